@@ -8,14 +8,14 @@
 #define CODECRAFTSDK_ALGORITHM_HPP
 
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <algorithm>
 #include <unordered_set>
 #include "Structure.hpp"
+#include "GridMap.hpp"
 #include "GlobalSetting.h"
 
-extern Game game;
-
 inline double Distance(const Point& p1, const Point& p2) {
     return sqrt((p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y));
 }
@@ -91,12 +91,32 @@ inline double RobotWorktopAngleDiff(const Robot& robot, const Worktop& worktop)
 }
 
 
+/**
+ * 是否处于终局阶段
+ */
+inline bool InEndgame(const Game& gameStatus) {
+    return global::TOTAL_FRAMES - gameStatus.curFrame <= global::ENDGAME_FRAMES;
+}
+
+/**
+ * 在特定游戏状态下再经过frames帧是否仍在比赛时间内
+ */
+inline bool WithinHorizon(const Game& gameStatus, int frames) {
+    return gameStatus.curFrame + frames + global::HORIZON_MARGIN_FRAMES <= global::TOTAL_FRAMES;
+}
+
+/**
+ * 状态估值
+ */
 inline double Estimate(const Game& gameStatus) {
     double res = 0.0;
     res -= gameStatus.curFrame * global::COST_PER_FRAME;
     res += gameStatus.money;
-    for (const auto& r: gameStatus.robots) {
-        res += r.ItemPrice();
+    // 终局阶段手上的物品不一定卖得出去，只计算已兑现的金钱
+    if (!InEndgame(gameStatus)) {
+        for (const auto& r: gameStatus.robots) {
+            res += r.ItemPrice();
+        }
     }
 #ifdef _DEBUG
 //    if (res == 0.0) {
@@ -106,6 +126,33 @@ inline double Estimate(const Game& gameStatus) {
     return res;
 }
 
+/**
+ * 子树最优值在置换表中的键：状态哈希不含携带物品的价值系数，而叶子的估值依赖它们，这里一并计入
+ */
+inline uint64_t SubtreeKey(const Game& gameStatus, const int robotIndex, const int remaining) {
+    uint64_t key = gameStatus.Key() ^ zobrist::Key(zobrist::Depth, robotIndex, remaining);
+    for (int i = 0, n = (int) gameStatus.robots.size(); i < n; i++) {
+        const Robot& r = gameStatus.robots[i];
+        if (r.carryingItemType != 0) {
+            uint64_t bits[2];
+            std::memcpy(&bits[0], &r.timeValueCoefficient, sizeof(double));
+            std::memcpy(&bits[1], &r.collisionValueCoefficient, sizeof(double));
+            key ^= zobrist::Key(zobrist::ValueCoefficient, i, zobrist::Mix(bits[0]) ^ bits[1]);
+        }
+    }
+    return key;
+}
+
+/**
+ * 特定机器人前往特定工作台的行程特征
+ */
+inline EtaModel::Features TripFeatures(const Game& gameStatus, const int& robotIndex, const int& worktopIndex) {
+    const Robot& curRobot = gameStatus.robots[robotIndex];
+    const Worktop& curWorktop = gameStatus.worktops[worktopIndex];
+    return EtaModel::MakeFeatures(gameStatus.grid->PathDistance(worktopIndex, curRobot.position, curWorktop.position),
+                                  RobotWorktopAngleDiff(curRobot, curWorktop), curRobot.carryingItemType != 0);
+}
+
 /**
  * 估算特定游戏状态下，特定机器人抵达特定工作台所需要的帧数
  * @param gameStatus 游戏状态
@@ -113,14 +160,67 @@ inline double Estimate(const Game& gameStatus) {
  * @param worktopIndex 工作台序号
  */
 inline int EstimateFrameCost(const Game& gameStatus, const int& robotIndex, const int& worktopIndex) {
-    const Robot& curRobot = gameStatus.robots[robotIndex];
-    const Worktop curWorktop = gameStatus.worktops[worktopIndex];
-
     // 这里估得少一点比较好
-    int res = int(Distance(curRobot.position, curWorktop.position) /
-                  (global::ASSUMED_ROBOT_VELOCITY * global::TIME_PER_FRAME) +
-                  fabs(RobotWorktopAngleDiff(curRobot, curWorktop)) /
-                  (global::ASSUMED_ROBOT_PALSTANCE * global::TIME_PER_FRAME));
+    return int(gameStatus.eta->Predict(TripFeatures(gameStatus, robotIndex, worktopIndex)));
+}
+
+/**
+ * 估算携带物品从某点前往工作台（送货段）所需的帧数，出发朝向未知，不计转向
+ */
+inline int EstimateFrameCost(const Game& gameStatus, const Point& from, const int& worktopIndex) {
+    const Point& to = gameStatus.worktops[worktopIndex].position;
+    return int(gameStatus.eta->Predict(
+            EtaModel::MakeFeatures(gameStatus.grid->PathDistance(worktopIndex, from, to), 0.0, true)));
+}
+
+/**
+ * 终局阶段送货后的额外收益：若送达的原料凑齐配方，且产品能在比赛结束前生产完并卖出，
+ * 则计入产品的利润，用于优先补完已经做了一半的生产链
+ * @param gameStatus 送货完成后的游戏状态
+ * @param worktopIndex 送货工作台
+ */
+inline double EndgameBonus(const Game& gameStatus, int worktopIndex) {
+    const Worktop& w = gameStatus.worktops[worktopIndex];
+    auto item = itemTypeDict.find(w.producingItemType);
+    if (item == itemTypeDict.end() || w.productionStatus || w.remainingProductionTime <= 0 ||
+        w.materialStatus != 0) {
+        return 0.0;
+    }
+    int best = -1;
+    for (int i = 0, n = (int) gameStatus.worktops.size(); i < n; i++) {
+        if ((gameStatus.worktops[i].purchasingItemBits & (1 << w.producingItemType)) == 0) {
+            continue;
+        }
+        int frames = EstimateFrameCost(gameStatus, w.position, i);
+        if (best == -1 || frames < best) {
+            best = frames;
+        }
+    }
+    if (best == -1 || !WithinHorizon(gameStatus, w.remainingProductionTime + best)) {
+        return 0.0;
+    }
+    return item->second.originalSellingPrice - item->second.purchasePrice;
+}
+
+/**
+ * 特定机器人下一步值得评估的工作台（按序号升序）：每种类型只取离机器人最近的若干个，
+ * 手上有物品时只看收购该物品的类型，空手时只看有产出的类型。
+ * 手上有物品时再去掉原料格已满的工作台：评估中原料格不会自己空出来，它们的估值就是不可交互的默认值
+ */
+inline std::vector<int> CandidateWorktops(const Game& gameStatus, const int robotIndex) {
+    const Robot& robot = gameStatus.robots[robotIndex];
+    const SpatialIndex& index = *gameStatus.spatial;
+    const int item = robot.carryingItemType;
+    int mask = item == 0 ? index.ProducerTypes() : index.BuyerTypes(item);
+    auto res = index.NearestByType(robot.position, mask, global::SPATIAL_K_PER_TYPE, [](int) {
+        return true;
+    });
+    if (item != 0) {
+        res.erase(std::remove_if(res.begin(), res.end(), [&](int i) {
+            return !gameStatus.availability.Test(AvailabilityIndex::Open, item, i);
+        }), res.end());
+    }
+    std::sort(res.begin(), res.end());
     return res;
 }
 
@@ -139,28 +239,53 @@ inline int EstimateFrameCost(const Game& gameStatus, const int& robotIndex, cons
  * @return
  */
 inline std::vector<double> EstimateWorktops(const Game& gameStatus, const int robotIndex, int depth) {
+    // 不在候选集中的工作台按不可交互处理
+    const Robot& robot = gameStatus.robots[robotIndex];
     std::vector<double> res;
+    for (const auto& w: gameStatus.worktops) {
+        res.push_back(-global::TOTAL_FRAMES * global::COST_PER_FRAME + (global::UNINTERACTABLE_PANELTY * 2) +
+                      Distance(robot.position, w.position));
+    }
 
-    for (int i = 0, n = (int) gameStatus.worktops.size(); i < n; i++) {
+    for (int i: CandidateWorktops(gameStatus, robotIndex)) {
 //        Game statusAfter = ApplySelection(gameStatus, robotIndex, i);
         Game statusAfter(gameStatus);
         auto frames = EstimateFrameCost(statusAfter, robotIndex, i);
-        statusAfter.UpdateWorktops(frames);
+        // 叶子节点的估值只与目标工作台有关
+        if (depth < global::SEARCH_DEPTH) {
+            statusAfter.UpdateWorktops(frames);
+        } else {
+            statusAfter.UpdateWorktop(i, frames);
+        }
         statusAfter.curFrame += frames;
         const Robot& robotAfter = statusAfter.robots[robotIndex];
         const Worktop& worktopAfter = statusAfter.worktops[i];
-        if (worktopAfter.Interactable(robotAfter)) {
+        // 送货时必须在比赛结束前送达
+        bool admissible = robotAfter.carryingItemType == 0 || WithinHorizon(gameStatus, frames);
+        if (admissible && worktopAfter.Interactable(robotAfter)) {
             statusAfter.ApplySelection(robotIndex, i);
             if (depth < global::SEARCH_DEPTH) {
-                std::vector<double> v = EstimateWorktops(statusAfter, robotIndex, depth + 1);
-                res.push_back(*std::max(v.begin(), v.end()));
+                // 不同的选择顺序会到达相同的状态，子树最优值按状态哈希缓存
+                const int remaining = global::SEARCH_DEPTH - depth;
+                const uint64_t key = SubtreeKey(statusAfter, robotIndex, remaining);
+                double best;
+                if (statusAfter.tt == nullptr || !statusAfter.tt->Probe(key, remaining, best)) {
+                    std::vector<double> v = EstimateWorktops(statusAfter, robotIndex, depth + 1);
+                    best = *std::max_element(v.begin(), v.end());
+                    if (statusAfter.tt != nullptr) {
+                        statusAfter.tt->Store(key, remaining, best);
+                    }
+                }
+                res[i] = best;
             } else {
-                double curScore = Estimate(statusAfter);
-                res.push_back(curScore);
+                res[i] = Estimate(statusAfter);
+                if (depth == 0 && robot.carryingItemType != 0) {
+                    res[i] += gameStatus.demand->DeliveryBonus(gameStatus.worktops[i], robot.carryingItemType);
+                }
             }
         } else {
-            res.push_back(-global::TOTAL_FRAMES * global::COST_PER_FRAME + (global::UNINTERACTABLE_PANELTY * 2) +
-                          Distance(robotAfter.position, worktopAfter.position));
+            res[i] = -global::TOTAL_FRAMES * global::COST_PER_FRAME + (global::UNINTERACTABLE_PANELTY * 2) +
+                     Distance(robotAfter.position, worktopAfter.position);
         }
     }
 
@@ -173,5 +298,72 @@ inline std::vector<double> EstimateWorktops(const Game& gameStatus, const int ro
     return res;
 }
 
+/**
+ * 对于空手的机器人，评估所有“取货-送货”两段任务
+ * 取货工作台与送货工作台成对评估，分数为两段都完成后的游戏状态估值
+ * @param gameStatus 游戏状态
+ * @param robotIndex 机器人序号
+ * @return 所有可行的两段任务（未排序）
+ */
+inline std::vector<Task> EstimateTaskChains(const Game& gameStatus, const int robotIndex) {
+    std::vector<Task> res;
+    if (gameStatus.robots[robotIndex].carryingItemType != 0) {
+        return res;
+    }
+
+    // 两段任务只涉及取货与送货两个工作台，其它工作台不必推进；
+    // 只复制一次游戏状态，每个候选评估完后回滚
+    const SpatialIndex& index = *gameStatus.spatial;
+    Game status(gameStatus);
+    for (int i: CandidateWorktops(gameStatus, robotIndex)) {
+        const int item = gameStatus.worktops[i].producingItemType;
+        if (item == 0) {
+            continue;
+        }
+        const Game::Savepoint picked = status.Save(robotIndex, i);
+        auto pickFrames = EstimateFrameCost(status, robotIndex, i);
+        status.UpdateWorktop(i, pickFrames);
+        status.curFrame += pickFrames;
+        if (status.worktops[i].Interactable(status.robots[robotIndex])) {
+            status.ApplySelection(robotIndex, i);
+        }
+        if (status.robots[robotIndex].carryingItemType != item) {
+            // 不能交互或者钱不够，买不起
+            status.Rollback(picked);
+            continue;
+        }
+
+        // 送货工作台按类型取离取货点最近的若干个
+        auto sinks = index.NearestByType(gameStatus.worktops[i].position, index.BuyerTypes(item),
+                                         global::SPATIAL_K_PER_TYPE, [i](int j) {
+                    return j != i;
+                });
+        std::sort(sinks.begin(), sinks.end());
+        for (int j: sinks) {
+            // 原料格已满的送货工作台在评估中一直收不了货
+            if (!status.availability.Test(AvailabilityIndex::Open, item, j)) {
+                continue;
+            }
+            const Game::Savepoint delivered = status.Save(robotIndex, j);
+            auto deliverFrames = EstimateFrameCost(status, robotIndex, j);
+            status.UpdateWorktop(j, pickFrames);
+            status.UpdateWorktop(j, deliverFrames);
+            status.curFrame += deliverFrames;
+            // 买了却来不及卖出的任务不接受
+            if (status.worktops[j].ItemAcceptable(item) && WithinHorizon(gameStatus, pickFrames + deliverFrames)) {
+                status.ApplySelection(robotIndex, j);
+                double score = Estimate(status) + gameStatus.demand->DeliveryBonus(gameStatus.worktops[j], item);
+                if (InEndgame(gameStatus)) {
+                    score += EndgameBonus(status, j);
+                }
+                res.push_back({score, i, j});
+            }
+            status.Rollback(delivered);
+        }
+        status.Rollback(picked);
+    }
+    return res;
+}
+
 
 #endif //CODECRAFTSDK_ALGORITHM_HPP
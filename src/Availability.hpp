@@ -0,0 +1,81 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_AVAILABILITY_HPP
+#define CODECRAFTSDK_AVAILABILITY_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 按物品类型索引的工作台可交互状态
+ *
+ * 每种物品两组位集：产品已做好、可以去买的生产者（Ready），以及该原料格空着、可以去卖的消费者（Open）。
+ * 第i个工作台对应位集的第i位。位按[字][组][物品]交错存放，加入工作台时只在末尾追加，已有的位不动。
+ * 由Game在工作台状态变化时逐个更新，不做整表扫描；随Game一起复制，每个副本各有一份。
+ */
+class AvailabilityIndex {
+public:
+    static constexpr int ITEM_COUNT = 8;    // 下标即物品类型，0不用
+
+    enum Kind : int {
+        Ready = 0,      // 产品格有产品的生产者
+        Open = 1,       // 原料格空着的消费者
+    };
+
+    /**
+     * 保证能容纳n个工作台
+     */
+    void Grow(int n) {
+        const size_t words = ((size_t) n + 63) / 64;
+        if (words * STRIDE > bits.size()) {
+            bits.resize(words * STRIDE, 0);
+        }
+    }
+
+    void Set(Kind kind, int item, int worktop, bool on) {
+        uint64_t& word = bits[(size_t) (worktop >> 6) * STRIDE + kind * ITEM_COUNT + item];
+        const uint64_t bit = uint64_t(1) << (worktop & 63);
+        word = on ? word | bit : word & ~bit;
+    }
+
+    bool Test(Kind kind, int item, int worktop) const {
+        return (bits[(size_t) (worktop >> 6) * STRIDE + kind * ITEM_COUNT + item] >> (worktop & 63)) & 1;
+    }
+
+    /**
+     * @return 是否有任何一个工作台处于该状态
+     */
+    bool Any(Kind kind, int item) const {
+        for (size_t i = kind * ITEM_COUNT + item; i < bits.size(); i += STRIDE) {
+            if (bits[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @return 是否有任何一种产品可以买
+     */
+    bool AnyReady() const {
+        for (size_t w = 0; w < bits.size(); w += STRIDE) {
+            uint64_t any = 0;
+            for (int item = 1; item < ITEM_COUNT; item++) {
+                any |= bits[w + Ready * ITEM_COUNT + item];
+            }
+            if (any != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr size_t STRIDE = 2 * ITEM_COUNT;
+
+    std::vector<uint64_t> bits;
+};
+
+#endif //CODECRAFTSDK_AVAILABILITY_HPP
@@ -0,0 +1,124 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_CAPTUREWRITER_HPP
+#define CODECRAFTSDK_CAPTUREWRITER_HPP
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "GlobalSetting.h"
+
+/**
+ * @brief 输入抓包的后台写入
+ *
+ * 把main从标准输入收到的原始字节原样追加到文件，得到的抓包可以用 capture_replayer 回放。
+ * 决策线程只把数据拷进内存缓冲区，攒够CAPTURE_FLUSH_BYTES后交换双缓冲，由后台线程写盘，
+ * 帧处理中不出现文件IO。
+ */
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+
+    CaptureWriter(const CaptureWriter&) = delete;
+
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    ~CaptureWriter() {
+        Close();
+    }
+
+    /**
+     * 打开抓包文件并启动后台线程
+     * @return 是否打开成功
+     */
+    bool Open(const char* path) {
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        front.reserve(global::CAPTURE_FLUSH_BYTES * 2);
+        back.reserve(global::CAPTURE_FLUSH_BYTES * 2);
+        writer = std::thread(&CaptureWriter::Run, this);
+        return true;
+    }
+
+    bool IsOpen() const {
+        return file != nullptr;
+    }
+
+    /**
+     * 追加收到的字节，未打开时什么都不做
+     */
+    void Append(std::string_view bytes) {
+        if (file == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        front.append(bytes.data(), bytes.size());
+        total += bytes.size();
+        if (front.size() >= (size_t) global::CAPTURE_FLUSH_BYTES) {
+            ready.notify_one();
+        }
+    }
+
+    /**
+     * 写出剩余数据并关闭文件
+     */
+    void Close() {
+        if (file == nullptr) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_one();
+        writer.join();
+        fclose(file);
+        file = nullptr;
+    }
+
+    /**
+     * @return 已追加的总字节数
+     */
+    size_t Total() const {
+        return total;
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready.wait(lock, [this] {
+                return closing || front.size() >= (size_t) global::CAPTURE_FLUSH_BYTES;
+            });
+            front.swap(back);
+            const bool last = closing;
+            lock.unlock();
+            fwrite(back.data(), 1, back.size(), file);
+            back.clear();
+            if (last) {
+                fflush(file);
+                return;
+            }
+            lock.lock();
+        }
+    }
+
+    FILE* file = nullptr;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::string front;     // 决策线程追加
+    std::string back;      // 后台线程写盘
+    size_t total = 0;
+    bool closing = false;
+};
+
+#endif //CODECRAFTSDK_CAPTUREWRITER_HPP
@@ -0,0 +1,118 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_DEMAND_HPP
+#define CODECRAFTSDK_DEMAND_HPP
+
+#include <array>
+#include <algorithm>
+
+#include "Structure.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 按需生产的需求模型
+ *
+ * 状态估值只看金钱，送原料给产品没人要的4、5、6号工作台和送给缺料的7号工作台得分一样。
+ * 这里从收购点往回拉需求：7号物品只要有8、9号工作台就有需求；某物品的需求为
+ * 缺这种原料（materialStatus中对应位为0）的工作台数按其产品的需求加权，减去已经做好或在机器人手上的存货。
+ * 送货时按送货工作台产品的需求及其下游价值给额外分数，原料越接近凑齐分数越高。
+ */
+class DemandModel {
+public:
+    static constexpr int ITEM_COUNT = 8;    // 下标即物品类型，0不用
+
+    /**
+     * 按当前局面重新计算需求，每帧调用一次，同一帧重复调用直接返回
+     */
+    void Update(const Game& game) {
+        if (game.curFrame == frame) {
+            return;
+        }
+        frame = game.curFrame;
+
+        std::array<bool, ITEM_COUNT> directSale{};
+        std::array<double, ITEM_COUNT> supply{};
+        for (const auto& w: game.worktops) {
+            if (w.producingItemType == 0) {
+                for (int item = 1; item < ITEM_COUNT; item++) {
+                    directSale[item] = directSale[item] || (w.purchasingItemBits & (1 << item)) != 0;
+                }
+            } else if (w.productionStatus) {
+                supply[w.producingItemType] += 1.0;
+            }
+        }
+        for (const auto& r: game.robots) {
+            if (r.carryingItemType > 0 && r.carryingItemType < ITEM_COUNT) {
+                supply[r.carryingItemType] += 1.0;
+            }
+        }
+
+        demand.fill(0.0);
+        value.fill(0.0);
+        demand[7] = directSale[7] ? 1.0 : 0.0;
+        value[7] = Profit(7);
+        // 消费者的物品类型总是更大，从大到小传播时消费者的需求已经算好
+        for (int item = ITEM_COUNT - 2; item > 0; item--) {
+            double pull = 0.0, downstream = 0.0;
+            int consumers = 0, lacking = 0;
+            for (const auto& w: game.worktops) {
+                const int product = w.producingItemType;
+                if (product == 0 || (w.purchasingItemBits & (1 << item)) == 0) {
+                    continue;
+                }
+                consumers++;
+                if ((w.materialStatus & (1 << item)) == 0) {
+                    lacking++;
+                    pull += demand[product];
+                    downstream += demand[product] * value[product] / Formula(product);
+                }
+            }
+            if (consumers > 0) {
+                demand[item] = std::clamp((pull - supply[item]) / consumers, 0.0, 1.0);
+            }
+            value[item] = Profit(item) + (lacking > 0 ? downstream / lacking : 0.0);
+        }
+    }
+
+    /**
+     * @return 物品的需求，0表示没有下游需要，1表示所有消费者都缺
+     */
+    double Demand(int itemType) const {
+        return itemType > 0 && itemType < ITEM_COUNT ? demand[itemType] : 0.0;
+    }
+
+    /**
+     * 把物品送到工作台的额外分数：产品有需求时按产品的下游价值与送达后原料的齐全程度给分，
+     * 8、9号工作台没有产品，不加分
+     * @param sink 送货前的工作台
+     * @param itemType 送达的物品
+     */
+    double DeliveryBonus(const Worktop& sink, int itemType) const {
+        const int product = sink.producingItemType;
+        if (product == 0 || !sink.ItemAcceptable(itemType)) {
+            return 0.0;
+        }
+        const int have = __builtin_popcount(sink.materialStatus | (1 << itemType));
+        const int need = __builtin_popcount(sink.purchasingItemBits);
+        return global::DEMAND_WEIGHT * demand[product] * value[product] * have / need;
+    }
+
+private:
+    static double Profit(int itemType) {
+        const ItemType& item = itemTypeDict.find(itemType)->second;
+        return item.originalSellingPrice - item.purchasePrice;
+    }
+
+    static int Formula(int itemType) {
+        return std::max((int) itemTypeDict.find(itemType)->second.formula.size(), 1);
+    }
+
+    int frame = -1;
+    std::array<double, ITEM_COUNT> demand{};
+    // 物品本身的利润加上它在下游产品中的份额
+    std::array<double, ITEM_COUNT> value{};
+};
+
+#endif //CODECRAFTSDK_DEMAND_HPP
@@ -0,0 +1,191 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_ENGINE_HPP
+#define CODECRAFTSDK_ENGINE_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+
+#include "RobotControl.hpp"
+
+/**
+ * @brief 可嵌入的决策引擎
+ *
+ * 一个对象就是一局比赛的全部状态（游戏状态、总控制器、规划器），不依赖全局变量，
+ * 同一进程中可以同时存在多个互不影响的实例。main只负责标准输入输出协议的解析与格式化，
+ * 离线判题器、调参与压力测试可以在进程内直接调用 LoadMap / Step，省去管道与文本解析。
+ * 控制器持有游戏状态的引用，因此引擎不可复制也不可移动，需要放进容器时用 std::unique_ptr。
+ */
+class Engine {
+public:
+    /**
+     * 判题器一帧输入中的一个工作台
+     */
+    struct WorktopInput {
+        int type;
+        double x, y;
+        int remainingProductionTime;
+        int materialStatus;
+        int productionStatus;
+    };
+
+    /**
+     * 判题器一帧输入中的一个机器人
+     */
+    struct RobotInput {
+        int worktopID;
+        int carryingItemType;
+        double timeValueCoefficient;
+        double collisionValueCoefficient;
+        double palstance;
+        double vx, vy;
+        double orientation;
+        double x, y;
+    };
+
+    /**
+     * 判题器的一帧输入
+     */
+    struct Frame {
+        int frameID = 0;
+        int money = 0;
+        std::vector<WorktopInput> worktops;
+        std::vector<RobotInput> robots;
+    };
+
+    Engine() : game(), controller(game) {}
+
+    Engine(const Engine&) = delete;
+
+    Engine& operator=(const Engine&) = delete;
+
+    ~Engine() {
+        game.Release();
+    }
+
+    /**
+     * 使用MCTS规划器，不设置时为贪心，需在LoadMap之前调用
+     */
+    void SetPlanner(std::unique_ptr<MCTSPlanner> mcts) {
+        planner = std::move(mcts);
+        game.assigner->SetPlanner(planner.get());
+    }
+
+    /**
+     * 设置预计算缓存的目录（需已存在），同一张地图的距离场只算一次，需在LoadMap之前调用
+     */
+    void SetCacheDir(std::string dir) {
+        cacheDir = std::move(dir);
+    }
+
+    /**
+     * 读取地图并完成距离场等预计算
+     * @param text 地图文本，每行一个地图行，遇到"OK"行或文本结束为止
+     * @return 地图中是否有机器人
+     */
+    bool LoadMap(std::string_view text) {
+        int row = 0;
+        uint64_t fingerprint = mapcache::FNV_OFFSET;
+        while (!text.empty()) {
+            size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            if (line.size() >= 2 && line[0] == 'O' && line[1] == 'K') {
+                break;
+            }
+            fingerprint = mapcache::HashLine(fingerprint, line);
+            for (int i = 0, n = (int) line.size(); i < n; i++) {
+                const double x = 0.25 + 0.5 * i, y = 49.75 - 0.5 * row;
+                if (line[i] == '#') {
+                    game.LoadObstacle(row, i);
+                } else if (line[i] == 'A') {
+                    game.LoadRobot(x, y);
+                } else if (line[i] >= '1' && line[i] <= '9') {
+                    game.LoadWorktop(x, y, line[i] - '0');
+                }
+            }
+            row++;
+        }
+        if (!cacheDir.empty()) {
+            game.grid->SetCache(cacheDir, fingerprint);
+        }
+        game.Init();
+        controller.Init();
+        return !game.robots.empty();
+    }
+
+    /**
+     * 处理一帧输入，返回本帧的控制指令，引用在下次调用前有效
+     * @param frame 判题器的输入，机器人数量以地图为准，多出的机器人忽略
+     */
+    const std::vector<Instruction>& Step(const Frame& frame) {
+        game.RefreshCurrentFrameID(frame.frameID);
+        game.RefreshCurrentMoney(frame.money);
+        for (int i = 0, n = (int) frame.worktops.size(); i < n; i++) {
+            const WorktopInput& w = frame.worktops[i];
+            game.RefreshWorktopStatus(i, w.type, w.x, w.y, w.remainingProductionTime, w.materialStatus,
+                                      w.productionStatus);
+        }
+        for (int i = 0, n = std::min((int) frame.robots.size(), RobotCount()); i < n; i++) {
+            const RobotInput& r = frame.robots[i];
+            game.RefreshRobotStatus(i, r.worktopID, r.carryingItemType, r.timeValueCoefficient,
+                                    r.collisionValueCoefficient, r.palstance, r.vx, r.vy, r.orientation, r.x, r.y);
+        }
+        controller.Update();
+        output.clear();
+        controller.TakeInstructions(output);
+        return output;
+    }
+
+    /**
+     * 本帧的指令已经输出，结束掉帧检测的计时；每次Step之后调用一次
+     */
+    void EndFrame() {
+        game.lag->EndFrame();
+    }
+
+    int RobotCount() const {
+        return (int) game.robots.size();
+    }
+
+    int WorktopCount() const {
+        return (int) game.worktops.size();
+    }
+
+    const Game& GetGame() const {
+        return game;
+    }
+
+    /**
+     * 输出结束报告
+     */
+    void Report(std::ostream& os) const {
+        controller.Report(os);
+    }
+
+    /**
+     * 把遥测写到文件
+     * @return 是否写入成功
+     */
+    bool DumpTelemetry(const char* path) const {
+        return game.telemetry->Dump(path);
+    }
+
+    uint64_t TelemetryTotal() const {
+        return game.telemetry->Total();
+    }
+
+private:
+    Game game;
+    GeneralController controller;
+    std::unique_ptr<MCTSPlanner> planner;
+    std::vector<Instruction> output;
+    std::string cacheDir;
+};
+
+#endif //CODECRAFTSDK_ENGINE_HPP
@@ -0,0 +1,146 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_ETAMODEL_HPP
+#define CODECRAFTSDK_ETAMODEL_HPP
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include "GlobalSetting.h"
+
+/**
+ * @brief 在线校准的行程帧数模型
+ *
+ * 帧数 ≈ w · [距离, 转角, 超过π/3的转角, 携带物品时的距离, 1]
+ * 用带遗忘因子的递推最小二乘拟合，权重初值取原先“匀速直线+匀速转向”的假设，
+ * 因此样本不足时与原估计一致。整张地图共用一个模型。
+ */
+class EtaModel {
+public:
+    static constexpr int FEATURE_COUNT = 5;
+    using Features = std::array<double, FEATURE_COUNT>;
+
+    struct Stats {
+        long long samples = 0;
+        double baselineAbsError = 0.0;  // 原假设的累计绝对误差（帧）
+        double modelAbsError = 0.0;     // 模型（更新前）的累计绝对误差（帧）
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            double n = s.samples == 0 ? 1.0 : (double) s.samples;
+            os << "samples: " << s.samples << " baselineMAE: " << s.baselineAbsError / n << " modelMAE: "
+               << s.modelAbsError / n;
+            return os;
+        }
+    };
+
+    EtaModel() {
+        weights = BaselineWeights();
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            for (int j = 0; j < FEATURE_COUNT; j++) {
+                P[i][j] = i == j ? global::ETA_PRIOR_VARIANCE : 0.0;
+            }
+        }
+    }
+
+    /**
+     * 构造特征
+     * @param distance 路程（米）
+     * @param angle 需要转过的角度（弧度，取绝对值）
+     * @param carrying 是否携带物品
+     */
+    static Features MakeFeatures(double distance, double angle, bool carrying) {
+        angle = std::fabs(angle);
+        return {distance, angle, std::max(0.0, angle - M_PI / 3), carrying ? distance : 0.0, 1.0};
+    }
+
+    /**
+     * 原先的假设：匀速直线加匀速转向
+     */
+    static Features BaselineWeights() {
+        return {1.0 / (global::ASSUMED_ROBOT_VELOCITY * global::TIME_PER_FRAME),
+                1.0 / (global::ASSUMED_ROBOT_PALSTANCE * global::TIME_PER_FRAME), 0.0, 0.0, 0.0};
+    }
+
+    static double Dot(const Features& a, const Features& b) {
+        double res = 0.0;
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            res += a[i] * b[i];
+        }
+        return res;
+    }
+
+    bool Calibrated() const {
+        return stats.samples >= global::ETA_MIN_SAMPLES;
+    }
+
+    /**
+     * 预测帧数，样本不足时退回原假设
+     */
+    double Predict(const Features& x) const {
+        double baseline = Dot(BaselineWeights(), x);
+        if (!Calibrated()) {
+            return baseline;
+        }
+        // 模型只做修正，不允许偏离原假设太多
+        return std::clamp(Dot(weights, x), baseline * 0.5, baseline * 3.0 + 50.0);
+    }
+
+    /**
+     * 记录一次实际行程
+     * @param x 出发时的特征
+     * @param frames 实际用去的帧数
+     */
+    void Observe(const Features& x, double frames) {
+        stats.samples++;
+        stats.baselineAbsError += std::fabs(Dot(BaselineWeights(), x) - frames);
+        stats.modelAbsError += std::fabs(Predict(x) - frames);
+
+        // 递推最小二乘 P = (P - k x^T P) / λ, w += k (y - w·x)
+        const double lambda = global::ETA_FORGETTING;
+        Features Px{};
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            Px[i] = Dot(P[i], x);
+        }
+        double denom = lambda + Dot(x, Px);
+        Features k{};
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            k[i] = Px[i] / denom;
+        }
+        double error = frames - Dot(weights, x);
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            weights[i] += k[i] * error;
+        }
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            for (int j = 0; j < FEATURE_COUNT; j++) {
+                P[i][j] = (P[i][j] - k[i] * Px[j]) / lambda;
+            }
+        }
+    }
+
+    const Features& Weights() const {
+        return weights;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const EtaModel& model) {
+        os << model.stats << " weights:";
+        for (auto w: model.weights) {
+            os << ' ' << w;
+        }
+        return os;
+    }
+
+private:
+    Features weights{};
+    std::array<Features, FEATURE_COUNT> P{};
+    Stats stats;
+};
+
+#endif //CODECRAFTSDK_ETAMODEL_HPP
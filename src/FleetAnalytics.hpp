@@ -0,0 +1,221 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_FLEETANALYTICS_HPP
+#define CODECRAFTSDK_FLEETANALYTICS_HPP
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <ostream>
+#include <algorithm>
+
+#include "Structure.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 机器人利用率与生产阻塞的统计
+ *
+ * 每帧由判题器输入驱动（RefreshRobotStatus与RefreshWorktopStatus），只记录真实局面，按三个维度累计帧数：
+ * 机器人：空手/携带，行驶、原地转向、停在工作台旁、在路上停住，以及携带的物品已经因时间损失了明显的售价；
+ * 工作台：生产中、产品格满导致生产完成后等待（阻塞）、缺原料；
+ * 物品：卖出与销毁次数，携带帧数，卖出时售价因时间与碰撞损失的金额，销毁损失的全部售价，以及生产者的阻塞帧数。
+ * 比赛结束时输出汇总，用于找出吞吐损失在哪里。
+ */
+class FleetAnalytics {
+public:
+    static constexpr int ITEM_COUNT = 8;    // 下标即物品类型，0不用
+
+    enum Activity : int {
+        Moving,         // 在行驶
+        Turning,        // 原地转向
+        Waiting,        // 停在工作台旁
+        Stalled,        // 不在工作台旁且没有在动
+        ACTIVITY_COUNT,
+    };
+
+    struct RobotStats {
+        long long frames = 0;
+        long long empty = 0;
+        long long activity[ACTIVITY_COUNT] = {};
+        long long decaying = 0;     // 携带物品且时间价值系数低于ANALYTICS_DECAY_COEFFICIENT
+    };
+
+    struct WorktopStats {
+        int type = 0;
+        bool raw = true;            // 不需要原料
+        long long frames = 0;
+        long long busy = 0;         // 剩余生产时间大于0
+        long long blocked = 0;      // 生产完成但产品格满
+        long long starved = 0;      // 缺原料，没有在生产
+    };
+
+    struct ItemStats {
+        long long sells = 0;        // 卖出次数
+        long long destroys = 0;     // 销毁次数
+        long long carried = 0;      // 携带帧数
+        long long decaying = 0;
+        double timeLoss = 0.0;      // 卖出时因时间价值系数损失的售价
+        double collisionLoss = 0.0; // 卖出时因碰撞价值系数损失的售价
+        double destroyLoss = 0.0;   // 销毁的物品按原始售价全额计入
+        long long blocked = 0;      // 生产者阻塞帧数
+    };
+
+    /**
+     * 记录机器人本帧的状态
+     */
+    void RecordRobot(int index, const Robot& robot) {
+        Resize(index);
+        RobotStats& s = robots[index];
+        Carry& prev = last[index];
+        const int item = robot.carryingItemType;
+        // 物品从手上消失时结算：上一帧发过销毁指令或者不在工作台旁（卖不出去）算销毁，损失全部售价；
+        // 否则算卖出，按最后一帧的系数计入时间与碰撞损失
+        if (prev.item != 0 && item != prev.item) {
+            ItemStats& is = items[prev.item];
+            const double price = itemTypeDict.find(prev.item)->second.originalSellingPrice;
+            if (prev.destroying || robot.worktopID == -1) {
+                is.destroys++;
+                is.destroyLoss += price;
+            } else {
+                is.sells++;
+                is.timeLoss += price * (1.0 - prev.timeCoef);
+                is.collisionLoss += price * prev.timeCoef * (1.0 - prev.collisionCoef);
+            }
+        }
+        prev = {item, robot.timeValueCoefficient, robot.collisionValueCoefficient, false};
+
+        s.frames++;
+        const double speed = robot.velocity.Magnitude();
+        Activity a = Moving;
+        if (speed < global::ANALYTICS_IDLE_SPEED) {
+            if (robot.worktopID != -1) {
+                a = Waiting;
+            } else if (std::abs(robot.palstance) > global::ANALYTICS_TURN_PALSTANCE) {
+                a = Turning;
+            } else {
+                a = Stalled;
+            }
+        }
+        s.activity[a]++;
+        if (item == 0) {
+            s.empty++;
+            return;
+        }
+        items[item].carried++;
+        if (robot.timeValueCoefficient < global::ANALYTICS_DECAY_COEFFICIENT) {
+            s.decaying++;
+            items[item].decaying++;
+        }
+    }
+
+    /**
+     * 本帧对机器人发出了销毁指令，下一帧物品消失时按销毁结算
+     */
+    void CountDestroy(int index) {
+        Resize(index);
+        last[index].destroying = true;
+    }
+
+    /**
+     * 记录工作台本帧的状态
+     */
+    void RecordWorktop(int index, const Worktop& worktop) {
+        if (index >= (int) worktops.size()) {
+            worktops.resize(index + 1);
+        }
+        WorktopStats& s = worktops[index];
+        s.type = worktop.type;
+        s.raw = worktop.purchasingItemBits == 0;
+        s.frames++;
+        if (worktop.remainingProductionTime > 0) {
+            s.busy++;
+        } else if (worktop.remainingProductionTime == 0 && worktop.productionStatus) {
+            s.blocked++;
+            if (worktop.producingItemType != 0) {
+                items[worktop.producingItemType].blocked++;
+            }
+        } else if (worktop.remainingProductionTime == -1 && worktop.producingItemType != 0) {
+            s.starved++;
+        }
+    }
+
+    const std::vector<RobotStats>& Robots() const {
+        return robots;
+    }
+
+    const std::vector<WorktopStats>& Worktops() const {
+        return worktops;
+    }
+
+    const ItemStats& Item(int itemType) const {
+        return items[itemType];
+    }
+
+    /**
+     * 输出汇总：每个机器人一行，每种物品一行，最后是阻塞帧数最多的ANALYTICS_TOP_WORKTOPS个需要原料的工作台
+     * （原料工作台的产品格几乎总是满的，只在物品汇总中体现），机器人与工作台的各项为占观测帧数的百分比
+     */
+    void Summary(std::ostream& os) const {
+        for (int i = 0, n = (int) robots.size(); i < n; i++) {
+            const RobotStats& s = robots[i];
+            os << "Robot No." << i << " (%): empty " << Percent(s.empty, s.frames) << " moving "
+               << Percent(s.activity[Moving], s.frames) << " turning " << Percent(s.activity[Turning], s.frames)
+               << " waiting " << Percent(s.activity[Waiting], s.frames) << " stalled "
+               << Percent(s.activity[Stalled], s.frames) << " decaying " << Percent(s.decaying, s.frames) << "\n";
+        }
+        for (int item = 1; item < ITEM_COUNT; item++) {
+            const ItemStats& s = items[item];
+            if (s.sells == 0 && s.destroys == 0 && s.carried == 0 && s.blocked == 0) {
+                continue;
+            }
+            os << "Item " << item << ": sells " << s.sells << " destroys " << s.destroys << " carried " << s.carried
+               << " decaying " << s.decaying << " time loss " << (long long) s.timeLoss << " collision loss "
+               << (long long) s.collisionLoss << " destroy loss " << (long long) s.destroyLoss
+               << " producers blocked " << s.blocked << "\n";
+        }
+        std::vector<int> order;
+        for (int i = 0, n = (int) worktops.size(); i < n; i++) {
+            if (!worktops[i].raw && worktops[i].blocked > 0) {
+                order.push_back(i);
+            }
+        }
+        const int top = std::min((int) order.size(), global::ANALYTICS_TOP_WORKTOPS);
+        std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](int a, int b) {
+            return worktops[a].blocked > worktops[b].blocked;
+        });
+        for (int k = 0; k < top; k++) {
+            const WorktopStats& s = worktops[order[k]];
+            os << "Worktop No." << order[k] << " (type " << s.type << ", %): busy " << Percent(s.busy, s.frames)
+               << " blocked " << Percent(s.blocked, s.frames) << " starved " << Percent(s.starved, s.frames)
+               << "\n";
+        }
+    }
+
+private:
+    struct Carry {
+        int item = 0;
+        double timeCoef = 1.0;
+        double collisionCoef = 1.0;
+        bool destroying = false;    // 上一帧发过销毁指令
+    };
+
+    void Resize(int index) {
+        if (index >= (int) robots.size()) {
+            robots.resize(index + 1);
+            last.resize(index + 1);
+        }
+    }
+
+    static double Percent(long long part, long long whole) {
+        return whole == 0 ? 0.0 : std::round(1000.0 * (double) part / (double) whole) / 10.0;
+    }
+
+    std::vector<RobotStats> robots;
+    std::vector<Carry> last;
+    std::vector<WorktopStats> worktops;
+    std::array<ItemStats, ITEM_COUNT> items{};
+};
+
+#endif //CODECRAFTSDK_FLEETANALYTICS_HPP
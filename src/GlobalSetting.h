@@ -21,7 +21,7 @@ namespace global {
     static constexpr double ITEM_VALUES[] =
             {0, 3000, 3200, 3400, 7100, 7800, 8300, 29000};
 
-    static constexpr double COST_PER_FRAME = 88.8;
+    static constexpr double COST_PER_FRAME = 150.0;
 
     // 角度差到帧数的换算比
 //    static constexpr double ANGLE_COEF = 1.2 / M_PI;
@@ -51,6 +51,149 @@ namespace global {
     static constexpr double UNINTERACTABLE_PANELTY = -50000000.0 - TOTAL_FRAMES * COST_PER_FRAME;
 
     // 无可互动工作台时，时间系数容忍下限
-    static double TIME_COEF_THRESHOLD = 0.90;
+    static constexpr double TIME_COEF_THRESHOLD = 0.90;
+
+    // 剩余帧数不超过此值时进入终局模式，只计算能兑现的收益
+    static constexpr int ENDGAME_FRAMES = 50 * 20;
+
+    // 完成时间估计的安全余量（帧）
+    static constexpr int HORIZON_MARGIN_FRAMES = 25;
+
+    // 置换表大小（2的幂次）
+    static constexpr int TT_SIZE_LOG2 = 16;
+
+    // 状态哈希只供多层搜索的置换表使用，SEARCH_DEPTH为0时不维护
+    static constexpr bool ZOBRIST_HASHING = SEARCH_DEPTH > 0;
+
+    // 行程帧数模型：权重先验方差，越小越信任原假设
+    static constexpr double ETA_PRIOR_VARIANCE = 0.1;
+
+    // 行程帧数模型：遗忘因子
+    static constexpr double ETA_FORGETTING = 0.995;
+
+    // 行程帧数模型：开始使用模型所需的样本数
+    static constexpr int ETA_MIN_SAMPLES = 12;
+
+    // MCTS每帧可用的搜索时间（毫秒），同一帧内多个机器人共享
+    static constexpr double MCTS_BUDGET_MS = 8.0;
+
+    // MCTS前向模拟的视野（帧）
+    static constexpr int MCTS_HORIZON_FRAMES = 1500;
+
+    // MCTS每个决策点展开的候选任务数
+    static constexpr int MCTS_BRANCHING = 6;
+
+    // MCTS搜索线程数，0表示使用全部核心
+    static constexpr int MCTS_THREADS = 0;
+
+    // UCT探索系数
+    static constexpr double MCTS_EXPLORATION = 0.7;
+
+    // 模拟中没有任务时的等待帧数
+    static constexpr int MCTS_IDLE_FRAMES = 25;
+
+    // 模拟策略随机选择的概率
+    static constexpr double MCTS_ROLLOUT_EPSILON = 0.2;
+
+    // 超过此帧数未使用的搜索树不再复用
+    static constexpr int MCTS_REUSE_FRAMES = 100;
+
+    // 单帧处理时间预算（毫秒），超出即进入降级模式
+    static constexpr double LAG_FRAME_BUDGET_MS = 12.0;
+
+    // 处理时间低于预算的这个比例才算恢复
+    static constexpr double LAG_RECOVER_RATIO = 0.5;
+
+    // 连续恢复多少帧后退出降级模式
+    static constexpr int LAG_RECOVER_FRAMES = 50;
+
+    // 降级模式下MCTS搜索时间的比例
+    static constexpr double LAG_MCTS_BUDGET_SCALE = 0.25;
+
+    // 降级模式下MCTS展开的候选任务数
+    static constexpr int LAG_MCTS_BRANCHING = 3;
+
+    // 降级模式下两段任务打分的缓存有效帧数
+    static constexpr int LAG_SCORE_CACHE_FRAMES = 10;
+
+    // 遥测环形缓冲区的记录数（2的幂次），每条16字节
+    static constexpr int TELEMETRY_SIZE_LOG2 = 16;
+
+    // 工作台空间索引的格子边长（米）
+    static constexpr double SPATIAL_CELL_SIZE = 5.0;
+
+    // 打分时每种类型的工作台只评估最近的这么多个
+    static constexpr int SPATIAL_K_PER_TYPE = 6;
+
+    // 送货时按需求给的额外分数相对产品下游价值的比例
+    static constexpr double DEMAND_WEIGHT = 1.0;
+
+    // 直线距离不超过这么多帧的行程时开始为下一站调整速度与朝向
+    static constexpr int PREROTATE_FRAMES = 25;
+
+    // 穿过工作台的转向圆弧离工作台中心的最大距离（米），判题器的交易半径为0.4米
+    static constexpr double PREROTATE_RADIUS = 0.3;
+
+    // 卡住检测的运动历史长度（帧）
+    static constexpr int MOTION_WINDOW_FRAMES = 64;
+
+    // 窗口内位移小于此值（米）、平均速度与角速度都很小时认为被顶住
+    static constexpr double MOTION_PINNED_DISTANCE = 0.2;
+    static constexpr double MOTION_PINNED_SPEED = 0.5;
+    static constexpr double MOTION_PINNED_PALSTANCE = 0.5;
+
+    // 窗口内始终离目标不超过此距离（米）且方位角单向转过半圈认为在绕圈
+    static constexpr double MOTION_ORBIT_RADIUS = 2.0;
+
+    // 角速度超过此值才计入换向，窗口内换向次数达到阈值且位移小于MOTION_JITTER_DISTANCE（米）认为在抖动
+    static constexpr double MOTION_JITTER_PALSTANCE = 0.3;
+    static constexpr int MOTION_JITTER_FLIPS = 8;
+    static constexpr double MOTION_JITTER_DISTANCE = 1.0;
+
+    // 恢复动作持续的帧数
+    static constexpr int MOTION_RECOVER_FRAMES = 20;
+
+    // 被顶住时倒车的速度，绕圈或抖动时重新接近目标的速度（米/秒）
+    static constexpr double MOTION_REVERSE_SPEED = -2.0;
+    static constexpr double MOTION_RECOVER_SPEED = 1.5;
+
+    // 同一任务中恢复超过此次数且手上没有物品时放弃任务重新分配
+    static constexpr int MOTION_MAX_RECOVERIES = 3;
+
+    // 时空预定表的格子边长（米）、时间窗口（帧）与视野（窗口数）
+    static constexpr double RESERVATION_CELL_SIZE = 2.0;
+    static constexpr int RESERVATION_WINDOW_FRAMES = 10;
+    static constexpr int RESERVATION_HORIZON = 16;
+
+    // 每个机器人重新规划路线的间隔（帧）
+    static constexpr int RESERVATION_REPLAN_FRAMES = 10;
+
+    // 只为这么多帧以内的冲突让路，更远的冲突等重新规划时再看
+    static constexpr int RESERVATION_LOOKAHEAD_FRAMES = 20;
+
+    // 机器人多于此数时场地过挤，绕行与让行只会互相堵住，不启用协同路线
+    static constexpr int RESERVATION_MAX_ROBOTS = 16;
+
+    // 侧向绕行点离冲突位置的距离（米）
+    static constexpr double RESERVATION_DETOUR = 2.0;
+
+    // 抵达后继续占住终点格子的窗口数
+    static constexpr int RESERVATION_DWELL_WINDOWS = 1;
+
+    // 运营统计中速度低于此值（米/秒）认为停住，停住时角速度超过ANALYTICS_TURN_PALSTANCE认为在原地转向
+    static constexpr double ANALYTICS_IDLE_SPEED = 0.1;
+    static constexpr double ANALYTICS_TURN_PALSTANCE = 0.5;
+
+    // 运营统计中携带物品的时间价值系数低于此值时认为售价已明显衰减
+    static constexpr double ANALYTICS_DECAY_COEFFICIENT = 0.95;
+
+    // 结束报告中列出阻塞帧数最多的工作台个数
+    static constexpr int ANALYTICS_TOP_WORKTOPS = 5;
+
+    // 距离场多线程计算的期限（毫秒，从读完地图算起），须在判题器给的初始化时间之内
+    static constexpr int MAP_BUILD_DEADLINE_MS = 2000;
+
+    // 输入抓包攒够这么多字节交给后台线程写盘
+    static constexpr int CAPTURE_FLUSH_BYTES = 1 << 16;
 }
 #endif //CODECRAFTSDK_GLOBALSETTING_H
@@ -0,0 +1,445 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_GRIDMAP_HPP
+#define CODECRAFTSDK_GRIDMAP_HPP
+
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "Structure.hpp"
+#include "SpatialIndex.hpp"
+#include "Demand.hpp"
+#include "MotionMonitor.hpp"
+#include "FleetAnalytics.hpp"
+#include "Reservation.hpp"
+#include "MapCache.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 由地图文本构建的占据栅格，以及每个工作台的距离场
+ *
+ * 栅格与地图文本一一对应：第row行第col列的中心坐标为 (0.25 + 0.5 * col, 49.75 - 0.5 * row)。
+ * 距离场从工作台所在格子出发做八邻域Dijkstra，单位为 1/STEP_COST 个格子边长。
+ * 只有有障碍的地图才需要距离场。设置了缓存目录时先找同一张地图的缓存文件，找到就映射进来直接用；
+ * 否则多线程计算，超过MAP_BUILD_DEADLINE_MS还没算完的工作台按直线距离处理，全部算完才写缓存。
+ */
+struct GridMap {
+    static constexpr int SIZE = 100;
+    static constexpr double CELL = 0.5;
+    static constexpr uint16_t STRAIGHT_COST = 10;
+    static constexpr uint16_t DIAGONAL_COST = 14;
+    // 紧贴障碍或边界的格子额外代价，避免贴墙行驶
+    static constexpr uint16_t WALL_PENALTY = 10;
+    static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+    // 沿距离场向前看的最大格数
+    static constexpr int LOOKAHEAD_CELLS = 16;
+    // 缓存文件格式，距离场的算法或代价改变时需要加一
+    static constexpr uint32_t CACHE_VERSION = 1;
+
+    enum class Source : int {
+        Unused,     // 无障碍地图，不需要距离场
+        Cache,      // 从缓存文件映射
+        Built,      // 启动时计算
+        Partial,    // 启动期限内没有算完
+    };
+
+    struct BuildStats {
+        Source source = Source::Unused;
+        int fields = 0;         // 可用的距离场个数
+        double ms = 0.0;        // 耗时（毫秒）
+        bool saved = false;     // 是否写了缓存
+
+        friend std::ostream& operator<<(std::ostream& os, const BuildStats& s) {
+            static const char* names[] = {"unused", "cache", "built", "partial"};
+            os << "source: " << names[(int) s.source] << " fields: " << s.fields << " ms: " << s.ms
+               << " saved: " << s.saved;
+            return os;
+        }
+    };
+
+    std::vector<uint8_t> obstacle = std::vector<uint8_t>(SIZE * SIZE, 0);
+    std::vector<uint8_t> nearWall = std::vector<uint8_t>(SIZE * SIZE, 0);
+    // fields[worktop * SIZE * SIZE + cell]，从缓存映射时为空
+    std::vector<uint16_t> fields;
+    // 距离场数据，指向fields或映射的缓存文件
+    const uint16_t* fieldData = nullptr;
+    // 每个工作台的距离场是否可用
+    std::vector<uint8_t> ready;
+    int worktopCount = 0;
+    bool hasObstacle = false;
+
+    static int Index(int row, int col) {
+        return row * SIZE + col;
+    }
+
+    static int Row(double y) {
+        return std::clamp(int((Game::mapSize - y) / CELL), 0, SIZE - 1);
+    }
+
+    static int Col(double x) {
+        return std::clamp(int(x / CELL), 0, SIZE - 1);
+    }
+
+    static int CellOf(const Point& p) {
+        return Index(Row(p.y), Col(p.x));
+    }
+
+    static Point Center(int cell) {
+        return {0.25 + CELL * (cell % SIZE), Game::mapSize - 0.25 - CELL * (cell / SIZE)};
+    }
+
+    bool Blocked(int row, int col) const {
+        return row < 0 || row >= SIZE || col < 0 || col >= SIZE || obstacle[Index(row, col)] != 0;
+    }
+
+    /**
+     * 标记障碍格
+     */
+    void SetObstacle(int row, int col) {
+        if (row >= 0 && row < SIZE && col >= 0 && col < SIZE) {
+            obstacle[Index(row, col)] = 1;
+            hasObstacle = true;
+        }
+    }
+
+    /**
+     * 使用缓存，需在Build之前调用
+     * @param dir 缓存目录，需已存在
+     * @param fingerprint 地图指纹
+     */
+    void SetCache(std::string_view dir, uint64_t fingerprint) {
+        cachePath = mapcache::ArtifactPath(dir, fingerprint, ".grid");
+        cacheFingerprint = fingerprint;
+    }
+
+    /**
+     * 读取地图后调用，计算贴墙标记与所有工作台的距离场
+     * @param worktops 工作台
+     */
+    void Build(const std::vector<Worktop>& worktops) {
+        const auto begin = std::chrono::steady_clock::now();
+        for (int row = 0; row < SIZE; row++) {
+            for (int col = 0; col < SIZE; col++) {
+                bool near = false;
+                for (int dr = -1; dr <= 1 && !near; dr++) {
+                    for (int dc = -1; dc <= 1 && !near; dc++) {
+                        near = Blocked(row + dr, col + dc);
+                    }
+                }
+                nearWall[Index(row, col)] = near ? 1 : 0;
+            }
+        }
+        worktopCount = (int) worktops.size();
+        ready.assign(worktopCount, 0);
+        if (hasObstacle) {
+            if (cachePath.empty() || !LoadCache()) {
+                BuildFields(worktops, begin + std::chrono::milliseconds(global::MAP_BUILD_DEADLINE_MS));
+            }
+        }
+        stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    const uint16_t* Field(int worktopIndex) const {
+        return fieldData + (size_t) worktopIndex * SIZE * SIZE;
+    }
+
+    /**
+     * @return 工作台的距离场是否可用
+     */
+    bool Ready(int worktopIndex) const {
+        return worktopIndex < worktopCount && ready[worktopIndex] != 0;
+    }
+
+    const BuildStats& GetStats() const {
+        return stats;
+    }
+
+    /**
+     * 从某点沿栅格到达工作台的路径长度（米），无障碍地图直接取直线距离
+     */
+    double PathDistance(int worktopIndex, const Point& from, const Point& worktopPosition) const {
+        double straight = std::hypot(from.x - worktopPosition.x, from.y - worktopPosition.y);
+        if (!hasObstacle || !Ready(worktopIndex)) {
+            return straight;
+        }
+        uint16_t d = Field(worktopIndex)[CellOf(from)];
+        if (d == UNREACHABLE) {
+            return straight;
+        }
+        return std::max(straight, d * CELL / STRAIGHT_COST);
+    }
+
+    /**
+     * 两点间的连线是否不经过障碍（考虑机器人半径）
+     */
+    bool LineOfSight(const Point& a, const Point& b, double radius) const {
+        double dx = b.x - a.x, dy = b.y - a.y;
+        double len = std::hypot(dx, dy);
+        if (len < 1e-6) {
+            return !Blocked(Row(a.y), Col(a.x));
+        }
+        double nx = -dy / len * radius, ny = dx / len * radius;
+        int steps = int(len / (CELL * 0.5)) + 1;
+        for (int s = 0; s <= steps; s++) {
+            double t = (double) s / steps;
+            double x = a.x + dx * t, y = a.y + dy * t;
+            if (x - radius < 0.0 || x + radius > Game::mapSize || y - radius < 0.0 || y + radius > Game::mapSize) {
+                // 边界不算障碍，机器人会被判题器夹在场地内
+                x = std::clamp(x, 0.0, Game::mapSize);
+                y = std::clamp(y, 0.0, Game::mapSize);
+            }
+            if (obstacle[CellOf({x, y})] || obstacle[CellOf({x + nx, y + ny})] ||
+                obstacle[CellOf({x - nx, y - ny})]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * 沿距离场找到下一个导航点：在可视范围内沿梯度走得最远的格子中心
+     * @param worktopIndex 目标工作台
+     * @param from 当前位置
+     * @param worktopPosition 目标工作台位置
+     * @param radius 机器人半径
+     */
+    Point NextWaypoint(int worktopIndex, const Point& from, const Point& worktopPosition, double radius) const {
+        if (!hasObstacle || !Ready(worktopIndex) || LineOfSight(from, worktopPosition, radius)) {
+            return worktopPosition;
+        }
+        const uint16_t* field = Field(worktopIndex);
+        int cell = CellOf(from);
+        if (field[cell] == UNREACHABLE) {
+            cell = NearestReachable(field, cell);
+            if (cell == -1) {
+                return worktopPosition;
+            }
+            return Center(cell);
+        }
+        Point best = Center(cell);
+        for (int step = 0; step < LOOKAHEAD_CELLS; step++) {
+            int next = Descend(field, cell);
+            if (next == cell) {
+                break;
+            }
+            cell = next;
+            Point p = Center(cell);
+            if (!LineOfSight(from, p, radius)) {
+                break;
+            }
+            best = p;
+        }
+        return best;
+    }
+
+private:
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t size;
+        uint32_t costs;         // 直行、斜行、贴墙代价，各占8位
+        uint32_t worktopCount;
+        uint64_t fingerprint;
+    };
+
+    static constexpr uint32_t COSTS = STRAIGHT_COST | (DIAGONAL_COST << 8) | (WALL_PENALTY << 16);
+
+    /**
+     * 映射缓存文件，格式或大小不符时当作没有
+     */
+    bool LoadCache() {
+        const size_t bytes = (size_t) worktopCount * SIZE * SIZE * sizeof(uint16_t);
+        if (!mapped.Open(cachePath.c_str())) {
+            return false;
+        }
+        CacheHeader header{};
+        if (mapped.Size() != sizeof(header) + bytes) {
+            mapped.Close();
+            return false;
+        }
+        memcpy(&header, mapped.Data(), sizeof(header));
+        if (memcmp(header.magic, "GRIDMAP", 8) != 0 || header.version != CACHE_VERSION || header.size != SIZE ||
+            header.costs != COSTS || header.worktopCount != (uint32_t) worktopCount ||
+            header.fingerprint != cacheFingerprint) {
+            mapped.Close();
+            return false;
+        }
+        fieldData = reinterpret_cast<const uint16_t*>(mapped.Data() + sizeof(header));
+        ready.assign(worktopCount, 1);
+        stats.source = Source::Cache;
+        stats.fields = worktopCount;
+        return true;
+    }
+
+    /**
+     * 多线程计算距离场，过了期限不再开始新的工作台；全部算完且设置了缓存时写缓存
+     */
+    void BuildFields(const std::vector<Worktop>& worktops, std::chrono::steady_clock::time_point deadline) {
+        fields.assign((size_t) worktopCount * SIZE * SIZE, UNREACHABLE);
+        fieldData = fields.data();
+        std::atomic<int> next{0}, done{0};
+        auto work = [&]() {
+            for (int i = next++; i < worktopCount && std::chrono::steady_clock::now() < deadline; i = next++) {
+                BuildField(CellOf(worktops[i].position), &fields[(size_t) i * SIZE * SIZE]);
+                ready[i] = 1;
+                done++;
+            }
+        };
+        const int threads = std::min<int>(worktopCount, (int) std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto& t: pool) {
+            t.join();
+        }
+        stats.fields = done;
+        stats.source = done == worktopCount ? Source::Built : Source::Partial;
+        if (stats.source == Source::Built && !cachePath.empty()) {
+            CacheHeader header{{'G', 'R', 'I', 'D', 'M', 'A', 'P', '\0'}, CACHE_VERSION, SIZE, COSTS,
+                               (uint32_t) worktopCount, cacheFingerprint};
+            stats.saved = mapcache::Write(cachePath, &header, sizeof(header), fields.data(),
+                                          fields.size() * sizeof(uint16_t));
+        }
+    }
+
+    void BuildField(int source, uint16_t* field) const {
+        using Node = std::pair<uint32_t, int>;
+        std::priority_queue<Node, std::vector<Node>, std::greater<>> open;
+        field[source] = 0;
+        open.emplace(0, source);
+        while (!open.empty()) {
+            auto [d, cell] = open.top();
+            open.pop();
+            if (d != field[cell]) {
+                continue;
+            }
+            int row = cell / SIZE, col = cell % SIZE;
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    if ((dr == 0 && dc == 0) || Blocked(row + dr, col + dc)) {
+                        continue;
+                    }
+                    // 斜向移动不允许穿过障碍的拐角
+                    if (dr != 0 && dc != 0 && (Blocked(row + dr, col) || Blocked(row, col + dc))) {
+                        continue;
+                    }
+                    int next = Index(row + dr, col + dc);
+                    uint32_t nd = d + (dr != 0 && dc != 0 ? DIAGONAL_COST : STRAIGHT_COST) +
+                                  (nearWall[next] ? WALL_PENALTY : 0);
+                    if (nd < field[next]) {
+                        field[next] = (uint16_t) std::min<uint32_t>(nd, UNREACHABLE - 1);
+                        open.emplace(field[next], next);
+                    }
+                }
+            }
+        }
+    }
+
+    int Descend(const uint16_t* field, int cell) const {
+        int row = cell / SIZE, col = cell % SIZE;
+        int best = cell;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                if (Blocked(row + dr, col + dc)) {
+                    continue;
+                }
+                int next = Index(row + dr, col + dc);
+                if (field[next] < field[best]) {
+                    best = next;
+                }
+            }
+        }
+        return best;
+    }
+
+    int NearestReachable(const uint16_t* field, int cell) const {
+        int row = cell / SIZE, col = cell % SIZE;
+        for (int r = 1; r < SIZE; r++) {
+            for (int dr = -r; dr <= r; dr++) {
+                for (int dc = -r; dc <= r; dc++) {
+                    if (std::max(std::abs(dr), std::abs(dc)) != r || Blocked(row + dr, col + dc)) {
+                        continue;
+                    }
+                    int next = Index(row + dr, col + dc);
+                    if (field[next] != UNREACHABLE) {
+                        return next;
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+
+    std::string cachePath;
+    uint64_t cacheFingerprint = 0;
+    mapcache::MappedFile mapped;
+    BuildStats stats;
+};
+
+inline Game::Game() : assigner(new Assigner(*this)), grid(new GridMap()),
+                      tt(global::SEARCH_DEPTH > 0 ? new TranspositionTable(global::TT_SIZE_LOG2) : nullptr),
+                      eta(new EtaModel()),
+                      lag(new LagMonitor()),
+                      telemetry(new telemetry::RingBuffer(global::TELEMETRY_SIZE_LOG2)),
+                      spatial(new SpatialIndex()), demand(new DemandModel()),
+                      motion(new MotionMonitor()), reservations(new ReservationTable()),
+                      analytics(new FleetAnalytics()) {}
+
+inline void Game::Init() {
+    assigner->Init();
+    grid->Build(worktops);
+    spatial->Build(worktops);
+}
+
+inline void Game::Release() {
+    delete assigner;
+    delete grid;
+    delete tt;
+    delete eta;
+    delete lag;
+    delete telemetry;
+    delete spatial;
+    delete demand;
+    delete motion;
+    delete reservations;
+    delete analytics;
+    assigner = nullptr;
+    grid = nullptr;
+    tt = nullptr;
+    eta = nullptr;
+    lag = nullptr;
+    telemetry = nullptr;
+    spatial = nullptr;
+    demand = nullptr;
+    motion = nullptr;
+    reservations = nullptr;
+    analytics = nullptr;
+}
+
+inline void Game::LoadObstacle(int row, int col) {
+    grid->SetObstacle(row, col);
+}
+
+inline void Game::RecordRobot(int index) {
+    motion->Record(index, robots[index]);
+    analytics->RecordRobot(index, robots[index]);
+}
+
+inline void Game::RecordWorktop(int index) {
+    analytics->RecordWorktop(index, worktops[index]);
+}
+
+#endif //CODECRAFTSDK_GRIDMAP_HPP
@@ -0,0 +1,143 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_LAGMONITOR_HPP
+#define CODECRAFTSDK_LAGMONITOR_HPP
+
+#include <chrono>
+#include <algorithm>
+#include <ostream>
+
+#include "GlobalSetting.h"
+
+/**
+ * @brief 掉帧检测与降级开关
+ *
+ * 判题器在选手超时的时候会跳过帧，表现为收到的帧号不连续。
+ * 出现跳帧或单帧处理时间超出预算时进入降级模式，连续若干帧处理时间
+ * 都远低于预算后恢复。降级模式下规划器应减少计算量，跳过的决策通过SkipDecision计数。
+ * 处理时间从收到帧号算到本帧的指令发出（EndFrame由输出指令的一方在发出之后调用）。
+ */
+class LagMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        long long frames = 0;
+        long long missedFrames = 0;     // 被判题器跳过的帧数
+        long long gaps = 0;             // 帧号不连续的次数
+        long long slowFrames = 0;       // 处理时间超出预算的帧数
+        long long degradedFrames = 0;   // 处于降级模式的帧数
+        long long degradeEntries = 0;   // 进入降级模式的次数
+        long long skippedFrames = 0;    // 降级模式下跳过了部分决策的帧数
+        double totalFrameMs = 0.0;
+        double maxFrameMs = 0.0;
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            os << "missedFrames: " << s.missedFrames << " gaps: " << s.gaps << " slowFrames: " << s.slowFrames
+               << " degradedFrames: " << s.degradedFrames << " degradeEntries: " << s.degradeEntries
+               << " skippedFrames: " << s.skippedFrames
+               << " avgFrameMs: " << (s.frames == 0 ? 0.0 : s.totalFrameMs / (double) s.frames)
+               << " maxFrameMs: " << s.maxFrameMs;
+            return os;
+        }
+    };
+
+    /**
+     * 收到新一帧的帧号
+     * @param frameID 帧号
+     */
+    void BeginFrame(int frameID) {
+        frameBegin = Clock::now();
+        lastGap = 0;
+        if (lastFrameID >= 0 && frameID > lastFrameID + 1) {
+            lastGap = frameID - lastFrameID - 1;
+            stats.missedFrames += lastGap;
+            stats.gaps++;
+            Degrade();
+        }
+        lastFrameID = frameID;
+        stats.frames++;
+        if (degraded) {
+            stats.degradedFrames++;
+        }
+    }
+
+    /**
+     * 当前帧的指令已经输出（进程内运行时为交给判题器），处理时间包含输出
+     */
+    void EndFrame() {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - frameBegin).count();
+        lastFrameMs = ms;
+        stats.totalFrameMs += ms;
+        stats.maxFrameMs = std::max(stats.maxFrameMs, ms);
+        if (ms > global::LAG_FRAME_BUDGET_MS) {
+            stats.slowFrames++;
+            Degrade();
+        } else if (degraded) {
+            if (ms < global::LAG_FRAME_BUDGET_MS * global::LAG_RECOVER_RATIO) {
+                if (++calmFrames >= global::LAG_RECOVER_FRAMES) {
+                    degraded = false;
+                }
+            } else {
+                calmFrames = 0;
+            }
+        }
+    }
+
+    /**
+     * 降级模式下本帧跳过了一项决策（如复用缓存的两段任务打分而不重新评估），每帧只计一次
+     */
+    void SkipDecision() {
+        if (skippedFrameID != lastFrameID) {
+            skippedFrameID = lastFrameID;
+            stats.skippedFrames++;
+        }
+    }
+
+    /**
+     * 是否处于降级模式
+     */
+    bool Degraded() const {
+        return degraded;
+    }
+
+    /**
+     * 本帧之前被跳过的帧数
+     */
+    int LastGap() const {
+        return lastGap;
+    }
+
+    /**
+     * 上一帧的处理时间（毫秒）
+     */
+    double LastFrameMs() const {
+        return lastFrameMs;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    void Degrade() {
+        if (!degraded) {
+            stats.degradeEntries++;
+        }
+        degraded = true;
+        calmFrames = 0;
+    }
+
+    int lastFrameID = -1;
+    int skippedFrameID = -1;
+    int lastGap = 0;
+    double lastFrameMs = 0.0;
+    bool degraded = false;
+    int calmFrames = 0;
+    Clock::time_point frameBegin{};
+    Stats stats;
+};
+
+#endif //CODECRAFTSDK_LAGMONITOR_HPP
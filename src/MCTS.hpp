@@ -0,0 +1,487 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_MCTS_HPP
+#define CODECRAFTSDK_MCTS_HPP
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <ostream>
+#include <cmath>
+
+#include "Structure.hpp"
+#include "Algorithm.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 蒙特卡洛树搜索任务规划器
+ *
+ * 以“某个机器人空闲时选择哪个任务”为决策点，用Game的UpdateWorktops/ApplySelection/Estimate
+ * 做事件驱动的前向模拟。开环搜索：节点只记录动作序列的统计，状态每次从根重新模拟，
+ * 因此树可以在帧之间沿已执行的动作复用。多线程各自建树（根并行），最后合并根节点统计。
+ */
+class MCTSPlanner {
+public:
+    struct Stats {
+        long long searches = 0;
+        long long iterations = 0;
+        long long reusedTrees = 0;
+        long long budgetExhausted = 0;   // 本帧预算用完，退回贪心
+        long long degradedSearches = 0;  // 降级模式下的搜索次数
+        double searchMs = 0.0;
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            os << "searches: " << s.searches << " iterations: " << s.iterations << " iterations/search: "
+               << (s.searches == 0 ? 0.0 : (double) s.iterations / (double) s.searches) << " reusedTrees: "
+               << s.reusedTrees << " budgetExhausted: " << s.budgetExhausted << " degradedSearches: "
+               << s.degradedSearches << " searchMs: " << s.searchMs;
+            return os;
+        }
+    };
+
+    explicit MCTSPlanner(int threadCount = global::MCTS_THREADS)
+            : threadCount(threadCount > 0 ? threadCount : std::max(1, (int) std::thread::hardware_concurrency())),
+              trees(this->threadCount) {}
+
+    /**
+     * 为空闲的机器人规划任务
+     * @param game 当前游戏状态（含分配器中其它机器人正在执行的任务）
+     * @param robotId 需要任务的机器人
+     * @param inFlight 各机器人正在执行的任务，worktopID为-1表示空闲
+     * @return 按访问次数排序的候选任务，为空表示没有算力预算，由调用方退回贪心
+     */
+    std::vector<Task> Plan(const Game& game, int robotId, const std::vector<Task>& inFlight) {
+        using Clock = std::chrono::steady_clock;
+        auto begin = Clock::now();
+        // 降级模式下缩小预算与分支数
+        const bool degraded = game.lag->Degraded();
+        if (game.curFrame != budgetFrame) {
+            budgetFrame = game.curFrame;
+            budgetLeftMs = global::MCTS_BUDGET_MS * (degraded ? global::LAG_MCTS_BUDGET_SCALE : 1.0);
+        }
+        if (budgetLeftMs <= 0.0) {
+            stats.budgetExhausted++;
+            return {};
+        }
+        auto deadline = begin + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(budgetLeftMs));
+
+        branching = degraded ? global::LAG_MCTS_BRANCHING : global::MCTS_BRANCHING;
+        if (degraded) {
+            stats.degradedSearches++;
+        }
+
+        Rollout root = MakeRoot(game, robotId, inFlight);
+        const double rootValue = Estimate(root.game);
+
+        // 树复用：上次执行的动作之后轮到的正是这个机器人
+        for (auto& t: trees) {
+            if (t.root != nullptr && t.root->decider == robotId && game.curFrame - t.frame <= global::MCTS_REUSE_FRAMES) {
+                stats.reusedTrees++;
+            } else {
+                t.root = std::make_unique<Node>();
+                t.root->decider = robotId;
+            }
+            t.frame = game.curFrame;
+            t.minValue = t.maxValue = 0.0;
+        }
+
+        std::vector<long long> iterations(threadCount, 0);
+        auto worker = [&](int index) {
+            std::mt19937 rng((uint32_t) (game.curFrame * 7919 + robotId * 131 + index));
+            Tree& tree = trees[index];
+            // 每次迭代前检查时限，预算用完后不再多做
+            while (Clock::now() < deadline) {
+                Iterate(tree, root, rootValue, rng);
+                iterations[index]++;
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threadCount; i++) {
+            workers.emplace_back(worker, i);
+        }
+        worker(0);
+        for (auto& w: workers) {
+            w.join();
+        }
+
+        // 合并各棵树根节点的统计：访问次数与总价值分别累加，分数为合并后的平均价值
+        std::unordered_map<long long, Merged> merged;
+        for (auto& t: trees) {
+            for (auto& c: t.root->children) {
+                auto& m = merged[ActionKey(c->action)];
+                m.visits += c->visits;
+                m.totalValue += c->totalValue;
+                m.action = c->action;
+            }
+        }
+        std::vector<Merged> ranked;
+        for (auto& m: merged) {
+            ranked.push_back(m.second);
+        }
+        std::sort(ranked.begin(), ranked.end(), [](const Merged& a, const Merged& b) {
+            return a.visits > b.visits;
+        });
+        std::vector<Task> res;
+        for (auto& r: ranked) {
+            r.action.score = r.visits == 0 ? 0.0 : r.totalValue / r.visits;
+            res.push_back(r.action);
+        }
+
+        double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        budgetLeftMs -= elapsed;
+        stats.searches++;
+        stats.searchMs += elapsed;
+        for (auto i: iterations) {
+            stats.iterations += i;
+        }
+        return res;
+    }
+
+    /**
+     * 告知规划器实际执行的任务，树的根移动到对应子节点
+     */
+    void Commit(const Task& task) {
+        for (auto& t: trees) {
+            if (t.root == nullptr) {
+                continue;
+            }
+            std::unique_ptr<Node> next;
+            for (auto& c: t.root->children) {
+                if (ActionKey(c->action) == ActionKey(task)) {
+                    next = std::move(c);
+                    break;
+                }
+            }
+            t.root = std::move(next);
+        }
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    struct Node {
+        Task action{0.0, -1, -1};
+        int decider = -1;           // 在该节点做决策的机器人，-1表示到达搜索视野末端
+        int visits = 0;
+        double totalValue = 0.0;
+        bool expanded = false;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    struct Merged {
+        int visits = 0;
+        double totalValue = 0.0;
+        Task action{0.0, -1, -1};
+    };
+
+    struct Tree {
+        std::unique_ptr<Node> root;
+        int frame = 0;
+        double minValue = 0.0, maxValue = 0.0;
+    };
+
+    struct Leg {
+        int frame;      // 预计到达的帧
+        int worktopID;
+        int slot;       // 0表示取产品，否则为送入的物品类型
+    };
+
+    /**
+     * 模拟用的状态：游戏状态加上每个机器人尚未完成的行程
+     */
+    struct Rollout {
+        Game game;
+        std::vector<std::vector<Leg>> legs;
+        std::vector<int> freeAt;
+        int horizon;
+    };
+
+    int threadCount;
+    std::vector<Tree> trees;
+    int budgetFrame = -1;
+    double budgetLeftMs = 0.0;
+    int branching = global::MCTS_BRANCHING;
+    Stats stats;
+
+    static long long ActionKey(const Task& t) {
+        return (long long) (t.worktopID + 1) * 65536 + (t.sinkID + 1);
+    }
+
+    static Rollout MakeRoot(const Game& game, int robotId, const std::vector<Task>& inFlight) {
+        Rollout r{game, {}, {}, game.curFrame + global::MCTS_HORIZON_FRAMES};
+        // 模拟在多线程中进行，不使用共享的置换表
+        r.game.tt = nullptr;
+        r.legs.resize(game.robots.size());
+        r.freeAt.assign(game.robots.size(), game.curFrame);
+        for (int i = 0; i < (int) game.robots.size(); i++) {
+            if (i != robotId && i < (int) inFlight.size() && inFlight[i].worktopID != -1) {
+                Schedule(r, i, inFlight[i]);
+            }
+        }
+        return r;
+    }
+
+    /**
+     * 安排机器人执行任务，记录各段的预计到达帧
+     */
+    static void Schedule(Rollout& r, int robotIndex, const Task& t) {
+        Game& g = r.game;
+        int frame = g.curFrame + EstimateFrameCost(g, robotIndex, t.worktopID);
+        const Worktop& first = g.worktops[t.worktopID];
+        int carrying = g.robots[robotIndex].carryingItemType;
+        r.legs[robotIndex].push_back({frame, t.worktopID, carrying});
+        if (t.sinkID != -1) {
+            frame += EstimateFrameCost(g, first.position, t.sinkID);
+            r.legs[robotIndex].push_back({frame, t.sinkID, first.producingItemType});
+        }
+        r.freeAt[robotIndex] = frame;
+    }
+
+    /**
+     * 推进模拟直到下一个空闲的机器人
+     * @return 需要决策的机器人，-1表示已到视野末端
+     */
+    static int NextDecider(Rollout& r) {
+        Game& g = r.game;
+        while (true) {
+            int robot = -1, when = INT_MAX;
+            for (int i = 0; i < (int) r.legs.size(); i++) {
+                int t = r.legs[i].empty() ? r.freeAt[i] : r.legs[i].front().frame;
+                if (t < when) {
+                    when = t;
+                    robot = i;
+                }
+            }
+            if (robot == -1 || when > r.horizon) {
+                if (r.horizon > g.curFrame) {
+                    g.UpdateWorktops(r.horizon - g.curFrame);
+                    g.curFrame = r.horizon;
+                }
+                return -1;
+            }
+            if (when > g.curFrame) {
+                g.UpdateWorktops(when - g.curFrame);
+                g.curFrame = when;
+            }
+            if (r.legs[robot].empty()) {
+                return robot;
+            }
+            Leg leg = r.legs[robot].front();
+            r.legs[robot].erase(r.legs[robot].begin());
+            g.ApplySelection(robot, leg.worktopID);
+        }
+    }
+
+    /**
+     * 任务是否与其它机器人尚未完成的行程冲突
+     */
+    static bool Conflicts(const Rollout& r, int robotIndex, const Task& t) {
+        const Game& g = r.game;
+        int carrying = g.robots[robotIndex].carryingItemType;
+        int firstSlot = carrying;
+        int sinkSlot = t.sinkID == -1 ? -1 : g.worktops[t.worktopID].producingItemType;
+        for (int i = 0; i < (int) r.legs.size(); i++) {
+            if (i == robotIndex) {
+                continue;
+            }
+            for (const auto& leg: r.legs[i]) {
+                auto clash = [&](int worktop, int slot) {
+                    return leg.worktopID == worktop && leg.slot == slot &&
+                           (slot == 0 || g.worktops[worktop].producingItemType != 0);
+                };
+                if (clash(t.worktopID, firstSlot) || (t.sinkID != -1 && clash(t.sinkID, sinkSlot))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * 树内展开用的候选任务：沿用贪心的打分，取前branching个
+     */
+    static std::vector<Task> Candidates(const Rollout& r, int robotIndex, int branching) {
+        const Game& g = r.game;
+        std::vector<Task> all;
+        if (g.robots[robotIndex].carryingItemType == 0) {
+            all = EstimateTaskChains(g, robotIndex);
+        } else {
+            auto scores = EstimateWorktops(g, robotIndex, 0);
+            int item = g.robots[robotIndex].carryingItemType;
+            for (int i = 0; i < (int) scores.size(); i++) {
+                if (g.worktops[i].ItemAcceptable(item)) {
+                    all.push_back({scores[i], i, -1});
+                }
+            }
+        }
+        std::sort(all.begin(), all.end(), [](const Task& a, const Task& b) {
+            return a.score > b.score;
+        });
+        std::vector<Task> res;
+        for (const auto& t: all) {
+            if ((int) res.size() >= branching) {
+                break;
+            }
+            if (!Conflicts(r, robotIndex, t)) {
+                res.push_back(t);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * 模拟阶段的快速策略：按单位时间利润挑选，带一定随机性，不复制游戏状态
+     */
+    static Task RolloutPolicy(const Rollout& r, int robotIndex, std::mt19937& rng) {
+        const Game& g = r.game;
+        const Robot& robot = g.robots[robotIndex];
+        const int n = (int) g.worktops.size();
+        auto nearestSink = [&](const Point& from, int item, int& frames) {
+            int best = -1;
+            for (int j = 0; j < n; j++) {
+                const Worktop& w = g.worktops[j];
+                if (!w.ItemAcceptable(item) || Conflicts(r, robotIndex, {0.0, j, -1})) {
+                    continue;
+                }
+                int f = EstimateFrameCost(g, from, j);
+                if (best == -1 || f < frames) {
+                    best = j;
+                    frames = f;
+                }
+            }
+            return best;
+        };
+        if (robot.carryingItemType != 0) {
+            int frames = 0;
+            return {0.0, nearestSink(robot.position, robot.carryingItemType, frames), -1};
+        }
+        std::vector<std::pair<double, Task>> options;
+        for (int i = 0; i < n; i++) {
+            const Worktop& w = g.worktops[i];
+            auto item = itemTypeDict.find(w.producingItemType);
+            if (item == itemTypeDict.end() || g.money < item->second.purchasePrice) {
+                continue;
+            }
+            int pickFrames = EstimateFrameCost(g, robotIndex, i);
+            if (!w.productionStatus && (w.remainingProductionTime < 0 || w.remainingProductionTime > pickFrames)) {
+                continue;
+            }
+            int deliverFrames = 0;
+            int sink = nearestSink(w.position, w.producingItemType, deliverFrames);
+            Task t{0.0, i, sink};
+            if (sink == -1 || Conflicts(r, robotIndex, t)) {
+                continue;
+            }
+            double profit = item->second.originalSellingPrice - item->second.purchasePrice;
+            options.emplace_back(profit / (pickFrames + deliverFrames + 1), t);
+        }
+        if (options.empty()) {
+            return {0.0, -1, -1};
+        }
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        if (coin(rng) < global::MCTS_ROLLOUT_EPSILON) {
+            return options[std::uniform_int_distribution<int>(0, (int) options.size() - 1)(rng)].second;
+        }
+        return std::max_element(options.begin(), options.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        })->second;
+    }
+
+    static void Apply(Rollout& r, int robotIndex, const Task& t) {
+        if (t.worktopID == -1) {
+            // 无事可做，原地等待一段时间
+            r.freeAt[robotIndex] = r.game.curFrame + global::MCTS_IDLE_FRAMES;
+        } else {
+            Schedule(r, robotIndex, t);
+        }
+    }
+
+    static Node* Select(Tree& tree, Node* node) {
+        Node* best = nullptr;
+        double bestScore = -1e300;
+        double range = std::max(tree.maxValue - tree.minValue, 1.0);
+        double logN = std::log((double) std::max(node->visits, 1));
+        for (auto& c: node->children) {
+            if (c->visits == 0) {
+                return c.get();
+            }
+            double q = (c->totalValue / c->visits - tree.minValue) / range;
+            double score = q + global::MCTS_EXPLORATION * std::sqrt(logN / c->visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = c.get();
+            }
+        }
+        return best;
+    }
+
+    void Iterate(Tree& tree, const Rollout& root, double rootValue, std::mt19937& rng) {
+        Rollout r = root;
+        std::vector<Node*> path{tree.root.get()};
+        Node* node = tree.root.get();
+        int decider = node->decider;
+
+        // 选择与展开
+        while (decider != -1) {
+            if (!node->expanded) {
+                node->expanded = true;
+                for (const auto& t: Candidates(r, decider, branching)) {
+                    auto child = std::make_unique<Node>();
+                    child->action = t;
+                    node->children.push_back(std::move(child));
+                }
+                if (node->children.empty()) {
+                    auto child = std::make_unique<Node>();
+                    node->children.push_back(std::move(child));
+                }
+            }
+            Node* child = Select(tree, node);
+            bool fresh = child->visits == 0;
+            Apply(r, decider, child->action);
+            decider = NextDecider(r);
+            child->decider = decider;
+            node = child;
+            path.push_back(node);
+            if (fresh) {
+                break;
+            }
+        }
+
+        // 模拟
+        while (decider != -1) {
+            Apply(r, decider, RolloutPolicy(r, decider, rng));
+            decider = NextDecider(r);
+        }
+
+        double value = Estimate(r.game) - rootValue;
+        if (tree.minValue == 0.0 && tree.maxValue == 0.0) {
+            tree.minValue = tree.maxValue = value;
+        }
+        tree.minValue = std::min(tree.minValue, value);
+        tree.maxValue = std::max(tree.maxValue, value);
+        for (auto* p: path) {
+            p->visits++;
+            p->totalValue += value;
+        }
+    }
+};
+
+inline std::vector<Task> PlanTasks(MCTSPlanner& planner, const Game& game, int robotId,
+                                   const std::vector<Task>& inFlight) {
+    return planner.Plan(game, robotId, inFlight);
+}
+
+inline void CommitTask(MCTSPlanner& planner, const Task& task) {
+    planner.Commit(task);
+}
+
+#endif //CODECRAFTSDK_MCTS_HPP
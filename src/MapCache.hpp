@@ -0,0 +1,191 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_MAPCACHE_HPP
+#define CODECRAFTSDK_MAPCACHE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CODECRAFTSDK_MAPCACHE_MMAP
+
+#elif defined(_WIN32)
+
+#include <process.h>
+
+#endif
+
+/**
+ * @brief 按地图指纹缓存的预计算结果
+ *
+ * 指纹是LoadMap读到的地图文本（不含行尾的\r与OK行）的64位哈希，同一张地图每次运行得到同一个指纹。
+ * 预计算结果以指纹命名存成文件，下次遇到同一张地图时整个映射进内存直接使用，不再复制或解析。
+ * 写文件时先写临时文件再改名，中途退出不会留下半个文件；临时文件名含进程号与进程内序号，
+ * 多个进程或同一进程的多个引擎同时为同一张地图写缓存时互不干扰，先改名的生效。
+ */
+namespace mapcache {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    /**
+     * 把一行地图文本并入指纹
+     * @param hash 之前各行的指纹，第一行传FNV_OFFSET
+     */
+    inline uint64_t HashLine(uint64_t hash, std::string_view line) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        for (char c: line) {
+            hash = (hash ^ (uint8_t) c) * FNV_PRIME;
+        }
+        return (hash ^ '\n') * FNV_PRIME;
+    }
+
+    /**
+     * @return 目录dir下指纹对应的文件名
+     */
+    inline std::string ArtifactPath(std::string_view dir, uint64_t fingerprint, const char* suffix) {
+        char name[32];
+        snprintf(name, sizeof name, "map-%016llx", (unsigned long long) fingerprint);
+        std::string path(dir);
+        if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+            path += '/';
+        }
+        return path + name + suffix;
+    }
+
+    /**
+     * 只读映射的文件，没有mmap的平台整个读进内存
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+            Close();
+        }
+
+        /**
+         * @return 文件是否存在且非空
+         */
+        bool Open(const char* path) {
+            Close();
+#ifdef CODECRAFTSDK_MAPCACHE_MMAP
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st{};
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                close(fd);
+                return false;
+            }
+            void* p = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) {
+                return false;
+            }
+            madvise(p, (size_t) st.st_size, MADV_WILLNEED);
+            data = (const char*) p;
+            size = (size_t) st.st_size;
+#else
+            FILE* file = fopen(path, "rb");
+            if (file == nullptr) {
+                return false;
+            }
+            char chunk[1 << 16];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof chunk, file)) > 0) {
+                buffer.insert(buffer.end(), chunk, chunk + n);
+            }
+            fclose(file);
+            data = buffer.data();
+            size = buffer.size();
+#endif
+            return size > 0;
+        }
+
+        void Close() {
+#ifdef CODECRAFTSDK_MAPCACHE_MMAP
+            if (data != nullptr) {
+                munmap((void*) data, size);
+            }
+#else
+            buffer.clear();
+            buffer.shrink_to_fit();
+#endif
+            data = nullptr;
+            size = 0;
+        }
+
+        const char* Data() const {
+            return data;
+        }
+
+        size_t Size() const {
+            return size;
+        }
+
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+#ifndef CODECRAFTSDK_MAPCACHE_MMAP
+        std::vector<char> buffer;
+#endif
+    };
+
+    /**
+     * @return 本进程独有的临时文件名
+     */
+    inline std::string TempPath(const std::string& path) {
+        static std::atomic<unsigned> sequence{0};
+#if defined(CODECRAFTSDK_MAPCACHE_MMAP)
+        const long pid = (long) getpid();
+#elif defined(_WIN32)
+        const long pid = (long) _getpid();
+#else
+        const long pid = 0;
+#endif
+        char suffix[48];
+        snprintf(suffix, sizeof suffix, ".%ld.%u.tmp", pid, sequence++);
+        return path + suffix;
+    }
+
+    /**
+     * 把头部与数据写成一个文件
+     * @return 是否写入成功，目录不存在或不可写时返回false
+     */
+    inline bool Write(const std::string& path, const void* header, size_t headerSize, const void* body,
+                      size_t bodySize) {
+        const std::string tmp = TempPath(path);
+        FILE* file = fopen(tmp.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        bool ok = fwrite(header, 1, headerSize, file) == headerSize && fwrite(body, 1, bodySize, file) == bodySize;
+        ok = fclose(file) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif //CODECRAFTSDK_MAPCACHE_HPP
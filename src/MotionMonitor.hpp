@@ -0,0 +1,206 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_MOTIONMONITOR_HPP
+#define CODECRAFTSDK_MOTIONMONITOR_HPP
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <ostream>
+
+#include "Structure.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 机器人运动历史与卡住检测
+ *
+ * 每个机器人保留最近MOTION_WINDOW_FRAMES帧的位置、速度、角速度与朝向（来自判题器的输入）。
+ * 只在窗口填满后检测，三种情况：
+ * 被卡住：窗口内几乎没有位移，也没有在原地转向，通常是被别的机器人或墙顶住；
+ * 绕圈：一直在目标附近，相对目标的方位角单向转过了半圈以上，通常是速度太快反复冲过目标；
+ * 抖动：角速度反复换向且没走多远。
+ */
+class MotionMonitor {
+public:
+    enum class Failure : int {
+        None,
+        Pinned,
+        Orbiting,
+        Jittering,
+        Count,
+    };
+
+    static constexpr int FAILURE_COUNT = (int) Failure::Count;
+
+    struct Sample {
+        Point position{0.0, 0.0};
+        Vector2d velocity{0.0, 0.0};
+        double palstance = 0.0;
+        double orientation = 0.0;
+    };
+
+    struct Stats {
+        long long detections[FAILURE_COUNT] = {};
+        // 每种情况损失的帧数：检测窗口加上恢复动作的帧数
+        long long frames[FAILURE_COUNT] = {};
+        long long replans = 0;
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            for (int f = 1; f < FAILURE_COUNT; f++) {
+                os << ToString((Failure) f) << ": " << s.detections[f] << " (" << s.frames[f] << " frames) ";
+            }
+            os << "replans: " << s.replans;
+            return os;
+        }
+    };
+
+    static const char* ToString(Failure f) {
+        switch (f) {
+            case Failure::Pinned:
+                return "pinned";
+            case Failure::Orbiting:
+                return "orbiting";
+            case Failure::Jittering:
+                return "jittering";
+            default:
+                return "none";
+        }
+    }
+
+    /**
+     * 记录机器人本帧的状态，每帧读取输入后调用
+     */
+    void Record(int robotIndex, const Robot& robot) {
+        if (robotIndex >= (int) histories.size()) {
+            histories.resize(robotIndex + 1);
+        }
+        History& h = histories[robotIndex];
+        h.samples[h.head] = {robot.position, robot.velocity, robot.palstance, robot.orientation};
+        h.head = (h.head + 1) % WINDOW;
+        if (h.size < WINDOW) {
+            h.size++;
+        }
+    }
+
+    /**
+     * 清空历史，换目标或恢复动作结束后调用，避免旧的轨迹再次触发
+     */
+    void Reset(int robotIndex) {
+        if (robotIndex < (int) histories.size()) {
+            histories[robotIndex].size = 0;
+        }
+    }
+
+    /**
+     * 按运动历史判断机器人是否卡住
+     * @param target 当前目标的位置
+     */
+    Failure Detect(int robotIndex, const Point& target) const {
+        if (robotIndex >= (int) histories.size() || histories[robotIndex].size < WINDOW) {
+            return Failure::None;
+        }
+        const History& h = histories[robotIndex];
+        const Sample& oldest = h.At(0);
+        const Sample& newest = h.At(WINDOW - 1);
+        const double displacement = Distance(oldest.position, newest.position);
+        if (Distance(newest.position, target) <= TRADE_RADIUS) {
+            return Failure::None;
+        }
+
+        double speed = 0.0, turning = 0.0, sweep = 0.0, farthest = 0.0;
+        int flips = 0, lastSign = 0;
+        for (int i = 0; i < WINDOW; i++) {
+            const Sample& s = h.At(i);
+            speed += s.velocity.Magnitude();
+            turning += std::abs(s.palstance);
+            farthest = std::max(farthest, Distance(s.position, target));
+            if (i > 0) {
+                sweep += Wrap(Bearing(s.position, target) - Bearing(h.At(i - 1).position, target));
+            }
+            if (std::abs(s.palstance) > global::MOTION_JITTER_PALSTANCE) {
+                int sign = s.palstance > 0.0 ? 1 : -1;
+                flips += lastSign != 0 && sign != lastSign;
+                lastSign = sign;
+            }
+        }
+        speed /= WINDOW;
+        turning /= WINDOW;
+
+        if (displacement < global::MOTION_PINNED_DISTANCE && speed < global::MOTION_PINNED_SPEED &&
+            turning < global::MOTION_PINNED_PALSTANCE) {
+            return Failure::Pinned;
+        }
+        if (farthest < global::MOTION_ORBIT_RADIUS && std::abs(sweep) > M_PI) {
+            return Failure::Orbiting;
+        }
+        if (flips >= global::MOTION_JITTER_FLIPS && displacement < global::MOTION_JITTER_DISTANCE) {
+            return Failure::Jittering;
+        }
+        return Failure::None;
+    }
+
+    /**
+     * 记一次检测，检测窗口内的帧都算作损失
+     */
+    void CountDetection(Failure f) {
+        stats.detections[(int) f]++;
+        stats.frames[(int) f] += WINDOW;
+    }
+
+    /**
+     * 恢复动作每进行一帧调用一次
+     */
+    void CountRecoveryFrame(Failure f) {
+        stats.frames[(int) f]++;
+    }
+
+    void CountReplan() {
+        stats.replans++;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    static constexpr int WINDOW = global::MOTION_WINDOW_FRAMES;
+    static constexpr double TRADE_RADIUS = 0.4;
+
+    struct History {
+        std::array<Sample, WINDOW> samples{};
+        int head = 0;
+        int size = 0;
+
+        /**
+         * @param i 0为最旧的样本
+         */
+        const Sample& At(int i) const {
+            return samples[(head - size + i + WINDOW) % WINDOW];
+        }
+    };
+
+    static double Distance(const Point& a, const Point& b) {
+        return std::hypot(a.x - b.x, a.y - b.y);
+    }
+
+    static double Bearing(const Point& from, const Point& to) {
+        return std::atan2(to.y - from.y, to.x - from.x);
+    }
+
+    static double Wrap(double angle) {
+        while (angle > M_PI) {
+            angle -= 2 * M_PI;
+        }
+        while (angle < -M_PI) {
+            angle += 2 * M_PI;
+        }
+        return angle;
+    }
+
+    std::vector<History> histories;
+    Stats stats;
+};
+
+#endif //CODECRAFTSDK_MOTIONMONITOR_HPP
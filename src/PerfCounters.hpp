@@ -0,0 +1,239 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_PERFCOUNTERS_HPP
+#define CODECRAFTSDK_PERFCOUNTERS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <ostream>
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+/**
+ * @brief 按帧内阶段统计的硬件性能计数器（仅Linux，基于perf_event_open）
+ *
+ * 周期、指令、缓存未命中、分支预测失败四个计数器各自打开并设置inherit，
+ * Open之后创建的线程（如MCTS的搜索线程）的计数也累计进来；inherit不支持按组读取，每个计数器单独read。
+ * 每帧开始时调用Start记下起点，每个阶段结束时调用Lap把与上一个点的差值记到该阶段。
+ * 只统计用户态；某个事件不被支持时跳过它，其余照常统计。结束时输出每帧均值、IPC与每千条指令的未命中数。
+ * 多路复用时计数器没有全程运行，报告中给出各计数器合计的运行时间占比，不做缩放。
+ */
+class PerfCounters {
+public:
+    enum Phase : int {
+        Parse,      // 解析输入
+        Update,     // 决策
+        Output,     // 输出指令
+        PHASE_COUNT,
+    };
+
+    enum Event : int {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        EVENT_COUNT,
+    };
+
+    PerfCounters() {
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            fds[e] = -1;
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        Close();
+    }
+
+    /**
+     * 打开计数器并开始计数，需要在创建工作线程之前调用
+     * @return 是否至少打开了一个计数器，失败原因见报告
+     */
+    bool Open() {
+#ifdef __linux__
+        static const uint64_t configs[EVENT_COUNT] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES};
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[e];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fd < 0) {
+                error = errno;
+                continue;
+            }
+            fds[e] = fd;
+            counted[e] = true;
+            opened++;
+        }
+        if (opened == 0) {
+            return false;
+        }
+        counting = true;
+        for (int fd: fds) {
+            if (fd != -1) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+        return true;
+#else
+        error = ENOSYS;
+        return false;
+#endif
+    }
+
+    bool IsOpen() const {
+        return counting;
+    }
+
+    /**
+     * 记下本帧的起点
+     */
+    void Start() {
+        if (counting) {
+            Read(last);
+        }
+    }
+
+    /**
+     * 把从上一个点到现在的计数记到阶段phase
+     */
+    void Lap(Phase phase) {
+        if (!counting) {
+            return;
+        }
+        Sample now;
+        if (!Read(now)) {
+            return;
+        }
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            totals[phase][e] += now.values[e] - last.values[e];
+        }
+        enabled += now.enabled - last.enabled;
+        running += now.running - last.running;
+        laps[phase]++;
+        last = now;
+    }
+
+    void Close() {
+#ifdef __linux__
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            if (fds[e] != -1) {
+                close(fds[e]);
+                fds[e] = -1;
+            }
+        }
+#endif
+        counting = false;
+    }
+
+    uint64_t Total(Phase phase, Event event) const {
+        return totals[phase][event];
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const PerfCounters& p) {
+        static const char* phaseNames[PHASE_COUNT] = {"parse", "update", "output"};
+        static const char* eventNames[EVENT_COUNT] = {"cycles", "instructions", "cacheMisses", "branchMisses"};
+        if (p.opened == 0) {
+            os << "Perf unavailable: " << strerror(p.error) << "\n";
+            return os;
+        }
+        for (int ph = 0; ph < PHASE_COUNT; ph++) {
+            const double n = p.laps[ph] == 0 ? 1.0 : (double) p.laps[ph];
+            const uint64_t* t = p.totals[ph];
+            os << "Perf " << phaseNames[ph] << " frames: " << p.laps[ph];
+            for (int e = 0; e < EVENT_COUNT; e++) {
+                os << " " << eventNames[e] << "/frame: ";
+                if (!p.counted[e]) {
+                    os << "n/a";
+                } else {
+                    os << (double) t[e] / n;
+                }
+            }
+            if (p.counted[Cycles] && p.counted[Instructions] && t[Cycles] != 0) {
+                os << " IPC: " << (double) t[Instructions] / (double) t[Cycles];
+            }
+            if (p.counted[Instructions] && t[Instructions] != 0) {
+                const double kilo = (double) t[Instructions] / 1000.0;
+                if (p.counted[CacheMisses]) {
+                    os << " cacheMPKI: " << (double) t[CacheMisses] / kilo;
+                }
+                if (p.counted[BranchMisses]) {
+                    os << " branchMPKI: " << (double) t[BranchMisses] / kilo;
+                }
+            }
+            os << "\n";
+        }
+        os << "Perf running: " << (p.enabled == 0 ? 0.0 : 100.0 * (double) p.running / (double) p.enabled)
+           << "% of enabled time\n";
+        return os;
+    }
+
+private:
+    struct Sample {
+        uint64_t values[EVENT_COUNT] = {};
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+
+    /**
+     * 逐个读出计数器，按事件放好，未打开的事件为0；启用与运行时间为各计数器之和
+     */
+    bool Read(Sample& sample) const {
+#ifdef __linux__
+        sample = Sample();
+        for (int e = 0; e < EVENT_COUNT; e++) {
+            if (!counted[e]) {
+                continue;
+            }
+            // 不按组读取时的布局：value, time_enabled, time_running
+            uint64_t buffer[3];
+            if (read(fds[e], buffer, sizeof(buffer)) != (ssize_t) sizeof(buffer)) {
+                return false;
+            }
+            sample.values[e] = buffer[0];
+            sample.enabled += buffer[1];
+            sample.running += buffer[2];
+        }
+        return true;
+#else
+        (void) sample;
+        return false;
+#endif
+    }
+
+    int fds[EVENT_COUNT];
+    bool counted[EVENT_COUNT] = {};     // 事件是否打开成功，关闭后仍保留用于报告
+    bool counting = false;
+    int opened = 0;
+    int error = 0;
+    Sample last;
+    uint64_t totals[PHASE_COUNT][EVENT_COUNT] = {};
+    long long laps[PHASE_COUNT] = {};
+    uint64_t enabled = 0;
+    uint64_t running = 0;
+};
+
+#endif //CODECRAFTSDK_PERFCOUNTERS_HPP
@@ -0,0 +1,135 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_PROTOCOL_HPP
+#define CODECRAFTSDK_PROTOCOL_HPP
+
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+
+#include "Engine.hpp"
+
+/**
+ * @brief 判题器输入协议的解析
+ *
+ * 输入是地图（以OK行结束）加上每帧的文本（同样以OK行结束）。main从标准输入按行读出一帧后解析，
+ * 回放工具直接解析mmap的抓包文件，两者共用这里的解析，结果与逐字段scanf一致。
+ * 进程内直接调用引擎的工具用Quantize与QuantizeCommand把输入输出变成经过文本协议后的值，
+ * 保证与通过管道运行main的结果逐位相同。
+ */
+namespace protocol {
+    inline void SkipSpace(std::string_view& text) {
+        size_t i = 0;
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\n' || text[i] == '\r' || text[i] == '\t')) {
+            i++;
+        }
+        text.remove_prefix(i);
+    }
+
+    /**
+     * 读一个数并前移，失败时不移动
+     */
+    template<typename T>
+    inline bool Read(std::string_view& text, T& value) {
+        SkipSpace(text);
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc()) {
+            return false;
+        }
+        text.remove_prefix(end - text.data());
+        return true;
+    }
+
+    /**
+     * 取出下一行（不含换行符）并前移
+     */
+    inline std::string_view NextLine(std::string_view& text) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        return line;
+    }
+
+    inline bool IsOK(std::string_view line) {
+        return line.size() >= 2 && line[0] == 'O' && line[1] == 'K';
+    }
+
+    /**
+     * 取出地图部分（含OK行）并前移到第一帧
+     */
+    inline std::string_view SplitMap(std::string_view& text) {
+        const char* begin = text.data();
+        while (!text.empty() && !IsOK(NextLine(text))) {
+        }
+        return {begin, (size_t) (text.data() - begin)};
+    }
+
+    /**
+     * 按printf格式输出再读回，得到经过文本协议后的值
+     */
+    inline double RoundTrip(const char* format, double value) {
+        char buffer[64];
+        const int n = snprintf(buffer, sizeof buffer, format, value);
+        double res = value;
+        std::from_chars(buffer, buffer + n, res);
+        return res;
+    }
+
+    /**
+     * 把直接由判题器状态填好的一帧量化成判题器文本输出的精度：工作台坐标保留两位小数，机器人的实数保留七位小数
+     */
+    inline void Quantize(Engine::Frame& frame) {
+        for (auto& w: frame.worktops) {
+            w.x = RoundTrip("%.2f", w.x);
+            w.y = RoundTrip("%.2f", w.y);
+        }
+        for (auto& r: frame.robots) {
+            for (double* v: {&r.timeValueCoefficient, &r.collisionValueCoefficient, &r.palstance, &r.vx, &r.vy,
+                             &r.orientation, &r.x, &r.y}) {
+                *v = RoundTrip("%.7f", *v);
+            }
+        }
+    }
+
+    /**
+     * 把指令参数量化成main输出的精度：Instruction::ToString按流的默认格式输出（六位有效数字，同%g）
+     */
+    inline double QuantizeCommand(double value) {
+        return RoundTrip("%g", value);
+    }
+
+    /**
+     * 解析一帧（含帧号与OK行）并前移
+     * @param robotCount 机器人数量以地图中的'A'为准
+     * @return 是否完整读到一帧
+     */
+    inline bool ParseFrame(std::string_view& text, Engine::Frame& frame, int robotCount) {
+        int K;
+        if (!Read(text, frame.frameID) || !Read(text, frame.money) || !Read(text, K) || K < 0) {
+            return false;
+        }
+        frame.worktops.resize(K);
+        for (auto& w: frame.worktops) {
+            if (!Read(text, w.type) || !Read(text, w.x) || !Read(text, w.y) ||
+                !Read(text, w.remainingProductionTime) || !Read(text, w.materialStatus) ||
+                !Read(text, w.productionStatus)) {
+                return false;
+            }
+        }
+        frame.robots.resize(robotCount);
+        for (auto& r: frame.robots) {
+            if (!Read(text, r.worktopID) || !Read(text, r.carryingItemType) ||
+                !Read(text, r.timeValueCoefficient) || !Read(text, r.collisionValueCoefficient) ||
+                !Read(text, r.palstance) || !Read(text, r.vx) || !Read(text, r.vy) ||
+                !Read(text, r.orientation) || !Read(text, r.x) || !Read(text, r.y)) {
+                return false;
+            }
+        }
+        SkipSpace(text);
+        return IsOK(NextLine(text));
+    }
+}
+
+#endif //CODECRAFTSDK_PROTOCOL_HPP
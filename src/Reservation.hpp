@@ -0,0 +1,216 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_RESERVATION_HPP
+#define CODECRAFTSDK_RESERVATION_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <ostream>
+#include <algorithm>
+#include <type_traits>
+
+#include "Structure.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 时空预定表，用于多机器人的协同路线
+ *
+ * 把场地划成边长RESERVATION_CELL_SIZE的粗网格，时间按RESERVATION_WINDOW_FRAMES帧分窗，
+ * 只保留从当前窗口起RESERVATION_HORIZON个窗口（环形，过期的窗口在下次写入时清空）。
+ * 每个(格子, 窗口)记录预定了它的机器人（位掩码，超过64个机器人时按序号取模共用位）。
+ * 机器人确定路线后按路线上的采样点逐窗口预定格子，并记下自己预定了哪些格子，
+ * 重新规划一个机器人时只撤销它自己的预定，不重建整张表。
+ * 路线按优先级处理：检查冲突时只看优先级更高的机器人，优先级低的机器人为它们让路。
+ * 规划顺序不按优先级：机器人按序号依次更新，看到的是优先级更高的机器人当前已有的预定，
+ * 其中序号在后的仍是它们上一次规划（最多RESERVATION_REPLAN_FRAMES帧前）的路线。
+ */
+class ReservationTable {
+public:
+    static constexpr int SIZE = (int) (Game::mapSize / global::RESERVATION_CELL_SIZE + 0.999);
+    static constexpr int HORIZON = global::RESERVATION_HORIZON;
+    static constexpr int WINDOW = global::RESERVATION_WINDOW_FRAMES;
+
+    struct Stats {
+        long long plans = 0;        // 规划次数
+        long long conflicts = 0;    // 直行路线与优先级更高的机器人冲突的次数
+        long long detours = 0;      // 选择侧向绕行
+        long long slowdowns = 0;    // 选择减速让行
+        long long unresolved = 0;   // 所有候选都冲突，按冲突最晚的走
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            os << "plans: " << s.plans << " conflicts: " << s.conflicts << " detours: " << s.detours
+               << " slowdowns: " << s.slowdowns << " unresolved: " << s.unresolved;
+            return os;
+        }
+    };
+
+    /**
+     * 一条候选路线：折线加上平均速度
+     */
+    struct Route {
+        std::vector<Point> points;      // 第一个点为出发位置
+        double speed;                   // 米/秒
+    };
+
+    ReservationTable() : masks((size_t) HORIZON * SIZE * SIZE, 0), stamps(HORIZON, -1) {}
+
+    static uint64_t Bit(int robot) {
+        return uint64_t(1) << (robot & 63);
+    }
+
+    /**
+     * 撤销机器人的全部预定
+     */
+    void Release(int robot) {
+        if (robot >= (int) owned.size()) {
+            return;
+        }
+        for (const auto& [window, cell]: owned[robot]) {
+            const int slot = window % HORIZON;
+            if (stamps[slot] == window) {
+                masks[(size_t) slot * SIZE * SIZE + cell] &= ~Bit(robot);
+            }
+        }
+        owned[robot].clear();
+    }
+
+    /**
+     * 按路线预定格子，抵达终点后再占住终点格子dwellWindows个窗口（交易与转向）
+     * @param frame 出发帧
+     */
+    void Reserve(int robot, int frame, const Route& route, int dwellWindows) {
+        if (robot >= (int) owned.size()) {
+            owned.resize(robot + 1);
+        }
+        Release(robot);
+        int lastWindow = -1, lastCell = -1;
+        Sample(frame, route, [&](int window, int cell) {
+            if (window == lastWindow && cell == lastCell) {
+                return false;
+            }
+            Mark(robot, window, cell);
+            lastWindow = window;
+            lastCell = cell;
+            return false;
+        });
+        if (lastWindow >= 0) {
+            const int end = std::min(lastWindow + dwellWindows, frame / WINDOW + HORIZON - 1);
+            for (int w = lastWindow + 1; w <= end; w++) {
+                Mark(robot, w, lastCell);
+            }
+        }
+    }
+
+    /**
+     * 路线与other中的机器人在同一窗口占用同一格子的最早帧数（相对出发帧）
+     * @param other 需要避让的机器人
+     * @return -1表示视野内没有冲突
+     */
+    int FirstConflict(int frame, const Route& route, uint64_t other, Point* where = nullptr) const {
+        int found = -1;
+        const int first = frame / WINDOW;
+        Sample(frame, route, [&](int window, int cell, const Point& p) {
+            const int slot = window % HORIZON;
+            if (stamps[slot] == window && (masks[(size_t) slot * SIZE * SIZE + cell] & other) != 0) {
+                found = std::max(0, (window - first) * WINDOW - frame % WINDOW);
+                if (where != nullptr) {
+                    *where = p;
+                }
+                return true;
+            }
+            return false;
+        });
+        return found;
+    }
+
+    static double Length(const Route& route) {
+        double len = 0.0;
+        for (size_t i = 1; i < route.points.size(); i++) {
+            len += std::hypot(route.points[i].x - route.points[i - 1].x, route.points[i].y - route.points[i - 1].y);
+        }
+        return len;
+    }
+
+    Stats& GetStats() {
+        return stats;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    static int CellOf(const Point& p) {
+        const int row = std::clamp(int(p.y / global::RESERVATION_CELL_SIZE), 0, SIZE - 1);
+        const int col = std::clamp(int(p.x / global::RESERVATION_CELL_SIZE), 0, SIZE - 1);
+        return row * SIZE + col;
+    }
+
+    void Mark(int robot, int window, int cell) {
+        const int slot = window % HORIZON;
+        uint64_t* row = &masks[(size_t) slot * SIZE * SIZE];
+        if (stamps[slot] != window) {
+            std::fill(row, row + SIZE * SIZE, 0);
+            stamps[slot] = window;
+        }
+        row[cell] |= Bit(robot);
+        owned[robot].emplace_back(window, cell);
+    }
+
+    /**
+     * 沿路线每隔半米采样一次，算出经过的(窗口, 格子)，超出视野即停止；visit返回true时提前结束
+     */
+    template<typename Visit>
+    static void Sample(int frame, const Route& route, Visit visit) {
+        constexpr double STEP = 0.5;
+        const int last = frame / WINDOW + HORIZON - 1;
+        const double framesPerMeter = global::FRAME_PER_SECOND / std::max(route.speed, 0.1);
+        double travelled = 0.0;
+        for (size_t i = 1; i < route.points.size(); i++) {
+            const Point& a = route.points[i - 1];
+            const Point& b = route.points[i];
+            const double len = std::hypot(b.x - a.x, b.y - a.y);
+            for (double s = 0.0; s < len; s += STEP) {
+                const double t = s / len;
+                const Point p(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+                const int window = (frame + int((travelled + s) * framesPerMeter)) / WINDOW;
+                if (window > last) {
+                    return;
+                }
+                if (Call(visit, window, CellOf(p), p)) {
+                    return;
+                }
+            }
+            travelled += len;
+        }
+        if (!route.points.empty()) {
+            const Point& p = route.points.back();
+            const int window = (frame + int(travelled * framesPerMeter)) / WINDOW;
+            if (window <= last) {
+                Call(visit, window, CellOf(p), p);
+            }
+        }
+    }
+
+    template<typename Visit>
+    static bool Call(Visit& visit, int window, int cell, const Point& p) {
+        if constexpr (std::is_invocable_v<Visit&, int, int, const Point&>) {
+            return visit(window, cell, p);
+        } else {
+            return visit(window, cell);
+        }
+    }
+
+    // masks[窗口槽 * SIZE * SIZE + 格子]
+    std::vector<uint64_t> masks;
+    // 每个窗口槽当前对应的窗口序号
+    std::vector<int> stamps;
+    // 每个机器人预定的(窗口, 格子)
+    std::vector<std::vector<std::pair<int, int>>> owned;
+    Stats stats;
+};
+
+#endif //CODECRAFTSDK_RESERVATION_HPP
@@ -9,113 +9,157 @@
 #include <memory>
 #include <ostream>
 #include <sstream>
+#include <variant>
 
 #include "Structure.hpp"
 #include "Algorithm.hpp"
+#include "MCTS.hpp"
+#include "Telemetry.hpp"
 
-#ifdef _DEBUG
-
-#include <windows.h>
-
-#endif
-
-struct Event {
-};
-
-struct GetTarget : public Event {
+/**
+ * 状态机事件，均为纯数据，不再继承公共基类
+ */
+struct GetTarget {
     explicit GetTarget(int target) : target(target) {}
 
     int target;
 };
 
-struct Blocked : public Event {
-    Blocked() {}
+struct Blocked {
 };
 
-struct Unblocked : public Event {
-    Unblocked() {}
+struct Unblocked {
 };
 
-struct Done : public Event {
-    Done() {}
+struct Done {
 };
 
-struct Abandon : public Event {
-    Abandon() {}
+struct Abandon {
 };
 
-struct RobotController;
-
-struct RobotState {
-
-    virtual void Update(RobotController* controller) = 0;
-
-    void React(const Event& e, RobotController*) {};
-
-    virtual void React(const GetTarget&, RobotController*) {};
-
-    virtual void React(const Blocked&, RobotController*) {};
-
-    virtual void React(const Unblocked&, RobotController*) {};
-
-    virtual void React(const Done&, RobotController*) {};
-
-    virtual void React(const Abandon&, RobotController*) {};
-
-    virtual std::string ToString() {
-        return "RobotState";
-    }
+/**
+ * 两段任务的取货段完成，立即开始送货
+ */
+struct LegDone {
 };
 
+/**
+ * 事件集合，variant的下标即转移表中的列号
+ */
+using Event = std::variant<GetTarget, Blocked, Unblocked, Done, Abandon, LegDone>;
 
-struct Assign : RobotState {
-    void Update(RobotController* controller) override;
-
-    void React(const GetTarget& t, RobotController* controller) override;
-
-    void React(const Abandon& a, RobotController* controller) override;
-
-    std::string ToString() override {
-        return "Assign";
-    }
-
-    static Assign& Instance() {
-        static Assign singleton;
-        return singleton;
-    }
+/**
+ * 机器人状态，每个机器人只保存一个枚举值
+ */
+enum class StateID : int {
+    Assign,
+    Pathfind,
+    Avoid,
+    Count,
 };
 
-struct Pathfind : RobotState {
-    void Update(RobotController* controller) override;
-
-    void React(const Blocked&, RobotController*) override;
-
-    void React(const Abandon&, RobotController*) override;
+static constexpr int STATE_COUNT = (int) StateID::Count;
 
-    void React(const Done&, RobotController*) override;
+static constexpr int EVENT_COUNT = (int) std::variant_size_v<Event>;
 
-    std::string ToString() override {
-        return "Pathfind";
+inline const char* ToString(StateID state) {
+    switch (state) {
+        case StateID::Assign:
+            return "Assign";
+        case StateID::Pathfind:
+            return "Pathfind";
+        case StateID::Avoid:
+            return "Avoid";
+        default:
+            return "RobotState";
     }
+}
 
-    static Pathfind& Instance() {
-        static Pathfind singleton;
-        return singleton;
-    }
-};
+inline const char* EventName(int eventIndex) {
+    static constexpr const char* names[EVENT_COUNT] = {"GetTarget", "Blocked", "Unblocked", "Done", "Abandon",
+                                                                 "LegDone"};
+    return names[eventIndex];
+}
 
-struct Avoid : RobotState {
-    void Update(RobotController* controller) override;
+/**
+ * 状态转移时执行的动作
+ */
+enum class Action : int {
+    None,
+    SetTarget,      // 设置目标工作台
+    AbandonTask,    // 结束任务并丢弃物品
+    FinishTrade,    // 交易并结束任务
+    BeginDelivery,  // 买入后直接转向送货工作台
+};
 
-    void React(const Unblocked&, RobotController*) override;
+struct Transition {
+    StateID next;
+    Action action;
+    bool handled;   // 为false表示该状态不响应此事件，记入统计
+};
 
-    std::string ToString() override {
-        return "Pathfind";
-    }
+/**
+ * 编译期转移表 transitionTable[当前状态][事件下标]
+ */
+static constexpr Transition transitionTable[STATE_COUNT][EVENT_COUNT] = {
+        // GetTarget, Blocked, Unblocked, Done, Abandon, LegDone
+        {       // Assign
+                {StateID::Pathfind, Action::SetTarget, true},
+                {StateID::Assign, Action::None, false},
+                {StateID::Assign, Action::None, false},
+                {StateID::Assign, Action::None, false},
+                {StateID::Assign, Action::AbandonTask, true},
+                {StateID::Assign, Action::None, false},
+        },
+        {       // Pathfind
+                {StateID::Pathfind, Action::None, false},
+                {StateID::Avoid, Action::None, true},
+                {StateID::Pathfind, Action::None, false},
+                {StateID::Assign, Action::FinishTrade, true},
+                {StateID::Assign, Action::AbandonTask, true},
+                {StateID::Pathfind, Action::BeginDelivery, true},
+        },
+        {       // Avoid
+                {StateID::Avoid, Action::None, false},
+                {StateID::Avoid, Action::None, false},
+                {StateID::Pathfind, Action::None, true},
+                {StateID::Avoid, Action::None, false},
+                {StateID::Assign, Action::AbandonTask, true},
+                {StateID::Avoid, Action::None, false},
+        },
+};
 
-    static Avoid& Instance() {
-        static Avoid singleton;
-        return singleton;
+/**
+ * 状态机统计，用于分析机器人在各状态停留的时间
+ */
+struct StateProfile {
+    long long frames[STATE_COUNT] = {};                     // 各状态停留帧数
+    long long transitions[STATE_COUNT][STATE_COUNT] = {};   // 状态转移次数
+    long long ignored[STATE_COUNT][EVENT_COUNT] = {};       // 未被响应的事件数
+
+    friend std::ostream& operator<<(std::ostream& os, const StateProfile& profile) {
+        os << "frames:";
+        for (int s = 0; s < STATE_COUNT; s++) {
+            os << ' ' << ToString((StateID) s) << '=' << profile.frames[s];
+        }
+        os << "\n\ttransitions:";
+        for (int from = 0; from < STATE_COUNT; from++) {
+            for (int to = 0; to < STATE_COUNT; to++) {
+                if (profile.transitions[from][to] != 0) {
+                    os << ' ' << ToString((StateID) from) << "->" << ToString((StateID) to) << '='
+                       << profile.transitions[from][to];
+                }
+            }
+        }
+        os << "\n\tignored:";
+        for (int s = 0; s < STATE_COUNT; s++) {
+            for (int e = 0; e < EVENT_COUNT; e++) {
+                if (profile.ignored[s][e] != 0) {
+                    os << ' ' << ToString((StateID) s) << '/' << EventName(e) << '=' << profile.ignored[s][e];
+                }
+            }
+        }
+        return os;
     }
 };
 
@@ -130,28 +174,29 @@ struct Instruction {
     int robotID;
     double value;
 
-    std::string ToString() const {
-        std::stringstream ss;
+    /**
+     * 指令在输出协议中的名字
+     */
+    static const char* TypeName(Type type) {
         switch (type) {
             case Type::forward:
-                ss << "forward";
-                break;
+                return "forward";
             case Type::rotate:
-                ss << "rotate";
-                break;
+                return "rotate";
             case Type::buy:
-                ss << "buy";
-                break;
+                return "buy";
             case Type::sell:
-                ss << "sell";
-                break;
+                return "sell";
             case Type::destroy:
-                ss << "destroy";
-                break;
+                return "destroy";
             default:
-
-                break;
+                return "";
         }
+    }
+
+    std::string ToString() const {
+        std::stringstream ss;
+        ss << TypeName(type);
         ss << ' ';
         ss << robotID;
         if (type == Type::forward || type == Type::rotate) {
@@ -163,16 +208,32 @@ struct Instruction {
 
 struct RobotController {
 private:
-    RobotState* curState;
+    StateID curState;
     Game& game;
     int robotIndex;
     int curTargetWorktopID;
+    int curSinkWorktopID;       // 两段任务中待送货的工作台
+    bool delivering;            // 是否处于两段任务的送货段
+    int tripStartFrame;         // 当前行程出发的帧，-1表示没有在记录
+    long long tripMissedFrames;  // 行程出发时累计的掉帧数
+    EtaModel::Features tripFeatures;
+    MotionMonitor::Failure recovery;    // 正在处理的卡住情况
+    int recoveryFrames;         // 当前恢复动作已进行的帧数
+    int recoveries;             // 当前任务中恢复的次数
+    int routeFrame;             // 上次规划路线的帧，-1表示需要重新规划
+    bool routeDetour;           // 是否在走侧向绕行点
+    Point routeVia;             // 侧向绕行点
+    double routeSpeed;          // 让行时的限速
     std::vector<Instruction> instructionCache;
+    StateProfile profile;
 
 public:
     explicit RobotController(Game& game, int robotIndex)
     // 初始状态为Assign
-            : curState(&Assign::Instance()), game(game), robotIndex(robotIndex), curTargetWorktopID(-1),
+            : curState(StateID::Assign), game(game), robotIndex(robotIndex), curTargetWorktopID(-1),
+              curSinkWorktopID(-1), delivering(false), tripStartFrame(-1), tripMissedFrames(0),
+              tripFeatures(), recovery(MotionMonitor::Failure::None), recoveryFrames(0), recoveries(0),
+              routeFrame(-1), routeDetour(false), routeVia(0.0, 0.0), routeSpeed(global::ASSUMED_ROBOT_VELOCITY),
               instructionCache() {
     }
 
@@ -192,8 +253,12 @@ public:
         return game.robots[robotIndex];
     }
 
-    RobotState& GetCurState() {
-        return *curState;
+    StateID GetCurState() const {
+        return curState;
+    }
+
+    const StateProfile& GetProfile() const {
+        return profile;
     }
 
     const std::vector<Instruction>& GetInstructionCache() {
@@ -205,18 +270,179 @@ public:
     }
 
     /**
-     * 由总控制器调用
+     * 由总控制器调用，按当前状态直接分派，不经过虚函数
      */
     void Update() {
-        curState->Update(this);
+        profile.frames[(int) curState]++;
+        switch (curState) {
+            case StateID::Assign:
+                UpdateAssign();
+                break;
+            case StateID::Pathfind:
+                UpdatePathfind();
+                break;
+            case StateID::Avoid:
+                UpdateAvoid();
+                break;
+            default:
+                break;
+        }
+    }
+
+    /**
+     * 响应事件，查转移表决定动作与下一状态
+     * @param e 事件
+     */
+    void React(const Event& e) {
+        const int eventIndex = (int) e.index();
+        const Transition& t = transitionTable[(int) curState][eventIndex];
+        if (!t.handled) {
+            profile.ignored[(int) curState][eventIndex]++;
+            return;
+        }
+        switch (t.action) {
+            case Action::SetTarget:
+                SetTargetWorktop(std::get<::GetTarget>(e).target);
+                BeginTrip(GetRobot().carryingItemType != 0);
+                break;
+            case Action::BeginDelivery:
+                TryDoTrade();
+                SetTargetWorktop(GameStatus().assigner->FinishLeg(RobotIndex()));
+                curSinkWorktopID = -1;
+                delivering = true;
+                // 买入在下一帧才生效，送货段按携带物品记录
+                BeginTrip(true);
+                ContinueMoving();
+                break;
+            case Action::AbandonTask:
+#ifdef _DEBUG
+                std::cerr << "Abandon! " << "at assigner size: " << GameStatus().assigner->Size();
+#endif
+                TerminateTask();
+                AbandonItem();
+                break;
+            case Action::FinishTrade:
+                if (TryDoTrade()) {
+#ifdef _DEBUG
+                    std::cerr << "Trading instructions: ";
+                    for (const auto& i: GetInstructionCache()) {
+                        std::cerr << i.ToString() << " ";
+                    }
+                    std::cerr << std::endl;
+#endif
+                }
+                TerminateTask();
+                break;
+            default:
+                break;
+        }
+        profile.transitions[(int) curState][(int) t.next]++;
+        game.telemetry->Push(game.curFrame, telemetry::Kind::Transition, robotIndex, (int) curState, (int) t.next,
+                             eventIndex, 0.0f);
+        curState = t.next;
     }
 
 private:
+    void UpdateAssign() {
+#ifdef _DEBUG
+        std::cerr << "-----------------------------------------------------------------------------------------"
+                  << std::endl;
+        std::cerr << "ROBOT: No." << RobotIndex() << std::endl << GetRobot() << std::endl;
+        std::cerr << "Assign::Update: " << std::endl;
+#endif
+        auto t = GetAssignedTask();
+        double score = t.score;
+        int target = t.worktopID;
+        curSinkWorktopID = t.sinkID;
+        if (target != -1) {
+#ifdef _DEBUG
+            std::cerr << "timeValueCoefficient: " << GetRobot().timeValueCoefficient << std::endl;
+#endif
+            if (GetRobot().timeValueCoefficient > 0.79 &&
+                GetRobot().timeValueCoefficient < global::TIME_COEF_THRESHOLD) {
+#ifdef _DEBUG
+                std::cerr << "Abandon at score: " << score << " timeValueCoefficient: "
+                          << GetRobot().timeValueCoefficient << std::endl;
+#endif
+                React(::Abandon{});
+            } else {
+                React(::GetTarget(target));
+            }
+        }
+        (void) score;
+    }
+
+    void UpdatePathfind() {
+        if (delivering && GetRobot().carryingItemType == 0) {
+            // 取货段买入失败，送货段没有意义
+            React(::Abandon{});
+        } else if (ReachTarget()) {
+            FinishTrip();
+            if (curSinkWorktopID != -1 && GetRobot().carryingItemType == 0) {
+                if (!WithinHorizon(GameStatus(), EstimateFrameCost(GameStatus(), GetRobot().position,
+                                                                   curSinkWorktopID))) {
+                    // 已经来不及送货，放弃买入
+                    React(::Abandon{});
+                } else {
+                    React(::LegDone{});
+                }
+            } else {
+                React(::Done{});
+            }
+        } else if (IsBlocked()) {
+            React(::Blocked{});
+        } else {
+            ContinueMoving();
+            if (!NotStucked()) {
+                if (GetRobot().timeValueCoefficient < global::TIME_COEF_THRESHOLD) {
+                    React(::Abandon{});
+                }
+            }
+        }
+    }
+
+    /**
+     * 卡住后的恢复动作：被顶住时倒车并转向脱离，绕圈或抖动时低速重新接近目标。
+     * 持续MOTION_RECOVER_FRAMES帧或抵达目标后回到寻路；同一任务反复卡住且空手时放弃任务重新分配
+     */
+    void UpdateAvoid() {
+        game.motion->CountRecoveryFrame(recovery);
+        if (ReachTarget() || ++recoveryFrames > global::MOTION_RECOVER_FRAMES) {
+            game.motion->Reset(robotIndex);
+            if (recoveries > global::MOTION_MAX_RECOVERIES && GetRobot().carryingItemType == 0) {
+                game.motion->CountReplan();
+                React(::Abandon{});
+            } else {
+                React(::Unblocked{});
+                ContinueMoving();
+            }
+            return;
+        }
+        if (recovery == MotionMonitor::Failure::Pinned) {
+            // 序号不同的机器人向不同方向转，避免两个机器人倒车后再次顶在一起
+            instructionCache.push_back(Instruction{
+                    .type = Instruction::Type::rotate,
+                    .robotID = robotIndex,
+                    .value = robotIndex % 2 == 0 ? M_PI / 2 : -M_PI / 2,
+            });
+            instructionCache.push_back(Instruction{
+                    .type = Instruction::Type::forward,
+                    .robotID = robotIndex,
+                    .value = global::MOTION_REVERSE_SPEED,
+            });
+        } else {
+            const Point& target = game.worktops[curTargetWorktopID].position;
+            GuideTo(target, Distance(GetRobot().position, target), global::MOTION_RECOVER_SPEED);
+        }
+    }
+
     /**
      * 内部函数，使机器人导航到某位置
      * @param target 目标点
+     * @param remaining 到最终目的地的剩余路程，用于决定减速
+     * @param speedLimit 线速度上限
      */
-    void GuideTo(const Point& target) {
+    void GuideTo(const Point& target, double remaining, double speedLimit = global::ASSUMED_ROBOT_VELOCITY) {
         const Robot& curRobot = GetRobot();
         Vector2d DistanceVector = FromTo(curRobot.position, target);//距离向量
         double DisVecForward = atan2(DistanceVector.y, DistanceVector.x);     //距离向量的方向
@@ -231,10 +457,10 @@ private:
         }
 
 
-        double Distance = DistanceVector.Magnitude();
+        double Distance = std::max(DistanceVector.Magnitude(), remaining);
         double tval = 2.0 * curRobot.Acceleration() * Distance;
         double theoMaxVector = sqrt(tval); //理论上的最大速度
-        double maxVector = theoMaxVector < 6.0 ? theoMaxVector : 6.0;
+        double maxVector = std::min(theoMaxVector, speedLimit);
 
         if (fabs(theta) > (M_PI / 3)) {
             maxVector = 0.0;
@@ -254,8 +480,35 @@ private:
         });
     }
 
+    /**
+     * 记录行程出发时的状态，用于校准行程帧数模型
+     * @param carrying 行程中是否携带物品
+     */
+    void BeginTrip(bool carrying) {
+        const Robot& curRobot = GetRobot();
+        const Worktop& target = game.worktops[curTargetWorktopID];
+        tripFeatures = EtaModel::MakeFeatures(
+                game.grid->PathDistance(curTargetWorktopID, curRobot.position, target.position),
+                RobotWorktopAngleDiff(curRobot, target), carrying);
+        tripStartFrame = game.curFrame;
+        tripMissedFrames = game.lag->GetStats().missedFrames;
+    }
+
+    /**
+     * 抵达目标，用实际帧数更新行程帧数模型
+     */
+    void FinishTrip() {
+        // 行程中被跳过的帧里机器人执行的是过时的指令，这样的样本不用于校准
+        if (tripStartFrame >= 0 && game.curFrame > tripStartFrame &&
+            game.lag->GetStats().missedFrames == tripMissedFrames) {
+            game.eta->Observe(tripFeatures, game.curFrame - tripStartFrame);
+        }
+        tripStartFrame = -1;
+    }
+
     void AbandonItem() {
         if (GetRobot().carryingItemType != 0) {
+            game.analytics->CountDestroy(robotIndex);
             instructionCache.push_back(Instruction{
                     .type = Instruction::Type::destroy,
                     .robotID = robotIndex,
@@ -267,14 +520,6 @@ private:
 public:
     // 外部控制接口，由状态调用
 
-    /**
-     * 控制接口，转换当前状态
-     * @param instance 状态的单例，由Instance()获得
-     */
-    void TransitState(RobotState& instance) {
-        curState = &instance;
-    }
-
     /**
      * 从全局分配器获取下一个任务
      * @return 工作台编号，若为-1则表示分配失败
@@ -290,6 +535,12 @@ public:
     void TerminateTask() {
         GameStatus().assigner->TaskOver(RobotIndex());
         curTargetWorktopID = -1;
+        curSinkWorktopID = -1;
+        delivering = false;
+        tripStartFrame = -1;
+        recoveries = 0;
+        routeFrame = -1;
+        game.reservations->Release(robotIndex);
     }
 
     /**
@@ -298,6 +549,8 @@ public:
      */
     void SetTargetWorktop(int worktopID) {
         curTargetWorktopID = worktopID;
+        game.motion->Reset(robotIndex);
+        routeFrame = -1;
 
 #ifdef _DEBUG
         std::cerr << "selected target No." << worktopID << std::endl;
@@ -309,7 +562,208 @@ public:
      * 控制接口，使机器人继续移动
      */
     void ContinueMoving() {
-        GuideTo(game.worktops[curTargetWorktopID].position);
+        const Robot& curRobot = GetRobot();
+        const Point& targetPosition = game.worktops[curTargetWorktopID].position;
+        Point waypoint = game.grid->NextWaypoint(curTargetWorktopID, curRobot.position, targetPosition,
+                                                 curRobot.Radius());
+        double remaining = game.grid->PathDistance(curTargetWorktopID, curRobot.position, targetPosition);
+        const bool cooperative = (int) game.robots.size() <= global::RESERVATION_MAX_ROBOTS;
+        if (cooperative && (routeFrame < 0 || game.curFrame - routeFrame >= global::RESERVATION_REPLAN_FRAMES)) {
+            PlanRoute(waypoint, targetPosition);
+        }
+        if (routeDetour && Distance(curRobot.position, routeVia) > global::RESERVATION_CELL_SIZE / 2) {
+            GuideTo(routeVia, Distance(curRobot.position, routeVia) + Distance(routeVia, waypoint));
+            return;
+        }
+        routeDetour = false;
+        if (routeSpeed < global::ASSUMED_ROBOT_VELOCITY) {
+            GuideTo(waypoint, remaining, routeSpeed);
+            return;
+        }
+        // 目标已经直线可达且快到了，按下一站调整速度与朝向
+        static constexpr double lookahead =
+                global::PREROTATE_FRAMES * global::ASSUMED_ROBOT_VELOCITY * global::TIME_PER_FRAME;
+        if (remaining <= lookahead && waypoint.x == targetPosition.x && waypoint.y == targetPosition.y) {
+            int next = PredictNextTarget(EstimateFrameCost(game, robotIndex, curTargetWorktopID));
+            if (next != -1) {
+                PreRotate(targetPosition, next);
+                return;
+            }
+        }
+        GuideTo(waypoint, remaining);
+    }
+
+    /**
+     * 优先级高于本机器人的机器人：携带物品价值高的优先，相同时序号小的优先
+     */
+    uint64_t HigherPriority() const {
+        auto priority = [&](int i) {
+            const int item = game.robots[i].carryingItemType;
+            return item > 0 ? global::ITEM_VALUES[item] : 0.0;
+        };
+        const double mine = priority(robotIndex);
+        uint64_t mask = 0;
+        for (int i = 0, n = (int) game.robots.size(); i < n; i++) {
+            const double p = priority(i);
+            if (i != robotIndex && (p > mine || (p == mine && i < robotIndex))) {
+                mask |= ReservationTable::Bit(i);
+            }
+        }
+        return mask & ~ReservationTable::Bit(robotIndex);
+    }
+
+    /**
+     * 按时空预定表规划到目标的路线并预定：直行路线在RESERVATION_LOOKAHEAD_FRAMES帧内与优先级更高的机器人冲突时，
+     * 在冲突位置两侧各取一个绕行点，再加上两档减速，选不冲突且最早抵达的；都冲突时保持直行。
+     * 机器人按序号顺序规划，优先级更高、序号在后的机器人的预定可能还是上一次规划的路线
+     * @param waypoint 沿距离场的下一个导航点
+     * @param target 目标位置
+     */
+    void PlanRoute(const Point& waypoint, const Point& target) {
+        ReservationTable& table = *game.reservations;
+        const Robot& curRobot = GetRobot();
+        const double speed = global::ASSUMED_ROBOT_VELOCITY;
+        auto makeRoute = [&](const Point* via, double v) {
+            ReservationTable::Route route{{curRobot.position}, v};
+            if (via != nullptr) {
+                route.points.push_back(*via);
+            }
+            if (waypoint.x != target.x || waypoint.y != target.y) {
+                route.points.push_back(waypoint);
+            }
+            route.points.push_back(target);
+            return route;
+        };
+
+        routeFrame = game.curFrame;
+        routeDetour = false;
+        routeSpeed = speed;
+        table.GetStats().plans++;
+        const uint64_t other = HigherPriority();
+        ReservationTable::Route chosen = makeRoute(nullptr, speed);
+        Point where = curRobot.position;
+        const int conflict = table.FirstConflict(game.curFrame, chosen, other, &where);
+        if (conflict != -1 && conflict <= global::RESERVATION_LOOKAHEAD_FRAMES) {
+            table.GetStats().conflicts++;
+            auto clear = [&](const ReservationTable::Route& route) {
+                int c = table.FirstConflict(game.curFrame, route, other);
+                return c == -1 || c > global::RESERVATION_LOOKAHEAD_FRAMES;
+            };
+            double best = std::numeric_limits<double>::infinity();
+            Vector2d dir = FromTo(curRobot.position, where);
+            const double len = dir.Magnitude();
+            for (int side = -1; side <= 1 && len > 1e-6; side += 2) {
+                Point via(where.x - dir.y / len * global::RESERVATION_DETOUR * side,
+                          where.y + dir.x / len * global::RESERVATION_DETOUR * side);
+                if (via.x < 1.0 || via.x > Game::mapSize - 1.0 || via.y < 1.0 || via.y > Game::mapSize - 1.0 ||
+                    !game.grid->LineOfSight(curRobot.position, via, curRobot.Radius()) ||
+                    !game.grid->LineOfSight(via, waypoint, curRobot.Radius())) {
+                    continue;
+                }
+                ReservationTable::Route route = makeRoute(&via, speed);
+                const double arrival = ReservationTable::Length(route) / speed;
+                if (arrival < best && clear(route)) {
+                    best = arrival;
+                    chosen = route;
+                    routeDetour = true;
+                    routeVia = via;
+                }
+            }
+            for (double v: {speed * 0.5, speed * 0.25}) {
+                ReservationTable::Route route = makeRoute(nullptr, v);
+                const double arrival = ReservationTable::Length(route) / v;
+                if (arrival < best && clear(route)) {
+                    best = arrival;
+                    chosen = route;
+                    routeDetour = false;
+                    routeSpeed = v;
+                }
+            }
+            if (best == std::numeric_limits<double>::infinity()) {
+                table.GetStats().unresolved++;
+            } else if (routeDetour) {
+                table.GetStats().detours++;
+            } else {
+                table.GetStats().slowdowns++;
+            }
+        }
+        table.Reserve(robotIndex, game.curFrame, chosen, global::RESERVATION_DWELL_WINDOWS);
+    }
+
+    /**
+     * 抵达当前目标后紧接着要去的工作台：两段任务取货段的下一站是送货工作台；
+     * 其它情况下交易后会买入目标工作台的产品（卖出后顺手买入要求产品格没有被其它机器人预定），
+     * 预测为离它最近的能收购该产品的工作台
+     * @param arriveFrames 估计的抵达帧数
+     * @return -1表示无法预测
+     */
+    int PredictNextTarget(int arriveFrames) const {
+        if (!delivering && curSinkWorktopID != -1) {
+            return curSinkWorktopID;
+        }
+        const Worktop& target = game.worktops[curTargetWorktopID];
+        const int product = target.producingItemType;
+        const bool ready = product != 0 && (target.productionStatus || (target.remainingProductionTime >= 0 &&
+                                                                         target.remainingProductionTime <=
+                                                                         arriveFrames));
+        // 终局阶段卖出后不再顺手买入，产品被其它机器人预定时也不买
+        const bool selling = game.robots[robotIndex].carryingItemType != 0;
+        if (!ready || (selling && (InEndgame(game) || game.assigner->ProductReserved(curTargetWorktopID, robotIndex)))) {
+            return -1;
+        }
+        auto buyers = game.spatial->NearestByType(target.position, game.spatial->BuyerTypes(product), 1,
+                                                  [&](int i) {
+                                                      return i != curTargetWorktopID &&
+                                                             game.availability.Test(AvailabilityIndex::Open,
+                                                                                    product, i);
+                                                  });
+        int best = -1;
+        for (int i: buyers) {
+            if (best == -1 || Distance(target.position, game.worktops[i].position) <
+                              Distance(target.position, game.worktops[best].position)) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * 接近目标时为下一站调整速度与朝向。转角超过π/3时原本要停车原地转向，
+     * 改为以最大角速度走一段圆弧穿过工作台：圆弧中点离工作台不超过PREROTATE_RADIUS，
+     * 由此得到半径与允许的速度，切点之前按这个速度提前减速，进入切点后边走边转
+     * @param target 当前目标
+     * @param next 下一站工作台
+     */
+    void PreRotate(const Point& target, int next) {
+        const Robot& curRobot = GetRobot();
+        const Point& nextPosition = game.worktops[next].position;
+        Point nextWaypoint = game.grid->NextWaypoint(next, target, nextPosition, curRobot.Radius());
+        double d = Distance(curRobot.position, target);
+        double turn = AngleDiff(Direction(target, nextWaypoint), Direction(curRobot.position, target));
+        if (std::abs(turn) <= M_PI / 3) {
+            GuideTo(target, d);
+            return;
+        }
+        // 掉头时半径趋于0，退化为停车原地转向
+        double half = std::min(std::abs(turn) / 2, M_PI / 2 - 1e-3);
+        double radius = global::PREROTATE_RADIUS / (1.0 / cos(half) - 1.0);
+        double arcSpeed = std::min(radius * global::ASSUMED_ROBOT_PALSTANCE, global::ASSUMED_ROBOT_VELOCITY);
+        double tangent = radius * tan(half);
+        if (d > tangent) {
+            GuideTo(target, d, sqrt(arcSpeed * arcSpeed + 2.0 * curRobot.Acceleration() * (d - tangent)));
+            return;
+        }
+        // turn为正表示下一站在逆时针方向
+        instructionCache.push_back(Instruction{
+                .type = Instruction::Type::rotate,
+                .robotID = robotIndex,
+                .value = turn > 0.0 ? global::ASSUMED_ROBOT_PALSTANCE : -global::ASSUMED_ROBOT_PALSTANCE,
+        });
+        instructionCache.push_back(Instruction{
+                .type = Instruction::Type::forward,
+                .robotID = robotIndex,
+                .value = arcSpeed,
+        });
     }
 
     /**
@@ -329,11 +783,14 @@ public:
                     .robotID = robotIndex,
                     .value = 0.0
             });
-            instructionCache.push_back(Instruction{
-                    .type = Instruction::Type::buy,
-                    .robotID = robotIndex,
-                    .value = 0.0
-            });
+            // 终局阶段不再顺手买入，由分配器决定是否值得再跑一趟；产品格被预定时留给预定它的机器人
+            if (!InEndgame(GameStatus()) && !GameStatus().assigner->ProductReserved(curTargetWorktopID, robotIndex)) {
+                instructionCache.push_back(Instruction{
+                        .type = Instruction::Type::buy,
+                        .robotID = robotIndex,
+                        .value = 0.0
+                });
+            }
             return true;
         } else {
             return false;
@@ -344,126 +801,32 @@ public:
         return GetRobot().worktopID == curTargetWorktopID;
     }
 
-    void Abandon() {
-        AbandonItem();
-    }
-
     bool NotStucked() {
         const auto& status = GameStatus();
-        for (auto& w: status.worktops) {
-            if (w.Interactable(GetRobot())) {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    bool Blocked() {
-        // TODO: 增加障碍判断
-        return false;
-    }
-};
-
-void Assign::Update(RobotController* controller) {
-#ifdef _DEBUG
-    std::cerr << "-----------------------------------------------------------------------------------------"
-              << std::endl;
-    std::cerr << "ROBOT: No." << controller->RobotIndex() << std::endl << controller->GetRobot() << std::endl;
-    std::cerr << "Assign::Update: " << std::endl;
-#endif
-    auto t = controller->GetAssignedTask();
-    double score = t.score;
-    int target = t.worktopID;
-    if (target != -1) {
-#ifdef _DEBUG
-        std::cerr << "timeValueCoefficient: " << controller->GetRobot().timeValueCoefficient << std::endl;
-#endif
-        if (controller->GetRobot().timeValueCoefficient > 0.79 &&
-            controller->GetRobot().timeValueCoefficient < global::TIME_COEF_THRESHOLD) {
-#ifdef _DEBUG
-            std::cerr << "Abandon at score: " << score << " timeValueCoefficient: "
-                      << controller->GetRobot().timeValueCoefficient << std::endl;
-#endif
-            controller->GetCurState().React(Abandon(), controller);
-        } else {
-            controller->GetCurState().React(GetTarget(target), controller);
-        }
-    }
-
-#ifdef _DEBUG
-    static long long count = 0;
-    if (count < 4) {
-        Sleep(500);
-    } else {
-        Sleep(500);
-    }
-    count++;
-#endif
-}
-
-void Assign::React(const GetTarget& t, RobotController* controller) {
-    controller->SetTargetWorktop(t.target);
-    controller->TransitState(Pathfind::Instance());
-}
-
-void Assign::React(const Abandon& a, RobotController* controller) {
-#ifdef _DEBUG
-    std::cerr << "Abandon! " << "at assigner size: " << controller->GameStatus().assigner->Size();
-
-#endif
-    controller->TerminateTask();
-    controller->Abandon();
-    controller->TransitState(Assign::Instance());
-}
-
-void Pathfind::Update(RobotController* controller) {
-    if (controller->ReachTarget()) {
-        controller->GetCurState().React(Done{}, controller);
-    } else if (controller->Blocked()) {
-        // TODO: 增加避障处理
-
-    } else {
-        controller->ContinueMoving();
-        if (!controller->NotStucked()) {
-            if (controller->GetRobot().timeValueCoefficient < global::TIME_COEF_THRESHOLD) {
-                controller->GetCurState().React(Abandon(), controller);
-            }
+        const Robot& robot = GetRobot();
+        // 通常当前目标就能交互
+        if (curTargetWorktopID != -1 && status.worktops[curTargetWorktopID].Interactable(robot)) {
+            return true;
         }
+        // 只需要存在一个能交互的工作台
+        return robot.carryingItemType == 0 ? status.availability.AnyReady()
+                                           : status.availability.Any(AvailabilityIndex::Open, robot.carryingItemType);
     }
-}
-
-void Pathfind::React(const Abandon& a, RobotController* controller) {
-    controller->TerminateTask();
-    controller->Abandon();
-    controller->TransitState(Assign::Instance());
-}
 
-void Pathfind::React(const Blocked&, RobotController* controller) {
-    controller->TerminateTask();
-    // TODO: 增加避障处理
-}
-
-void Pathfind::React(const Done&, RobotController* controller) {
-    if (controller->TryDoTrade()) {
-#ifdef _DEBUG
-        std::cerr << "Trading instructions: ";
-        for (const auto& i: controller->GetInstructionCache()) {
-            std::cerr << i.ToString() << " ";
+    /**
+     * 按运动历史判断是否卡住，卡住时记下情况供恢复动作使用
+     */
+    bool IsBlocked() {
+        recovery = game.motion->Detect(robotIndex, game.worktops[curTargetWorktopID].position);
+        if (recovery == MotionMonitor::Failure::None) {
+            return false;
         }
-        std::cerr << std::endl;
-#endif
+        game.motion->CountDetection(recovery);
+        recoveryFrames = 0;
+        recoveries++;
+        return true;
     }
-    controller->TerminateTask();
-    controller->TransitState(Assign::Instance());
-}
-
-void Avoid::Update(RobotController* controller) {
-    // TODO: 增加避障处理
-}
-
-void Avoid::React(const Unblocked&, RobotController*) {
-    // TODO: 增加避障处理
-}
+};
 
 /**
  * 总控制器（必须在读取地图之后进行初始化，即调用Init）
@@ -484,33 +847,79 @@ struct GeneralController {
     }
 
     /**
-     * 刷新控制器状态，每一帧调用
+     * 刷新控制器状态，每一帧调用，所有机器人在同一趟循环中按状态分派
      */
     void Update() {
-        for (size_t i = 0; i < controllers.size(); i++) {
-#ifdef _DEBUG
-#endif
-            controllers[i].Update();
+        Record();
+        game.demand->Update(game);
+        for (auto& c: controllers) {
+            c.Update();
         }
     }
 
     /**
-     * 获取输出的控制指令
-     * @return
+     * 记录本帧的紧凑状态到遥测缓冲区
      */
-    std::string GetOutput() {
-        std::vector<Instruction> instructions;
+    void Record() const {
+        const LagMonitor& lag = *game.lag;
+        game.telemetry->Push(game.curFrame, telemetry::Kind::Frame, 0, lag.Degraded(),
+                             std::min(lag.LastGap(), 255), game.money, (float) lag.LastFrameMs());
+        for (const auto& c: controllers) {
+            const Robot& r = game.robots[c.RobotIndex()];
+            game.telemetry->Push(game.curFrame, telemetry::Kind::Robot, c.RobotIndex(), r.carryingItemType,
+                                 (int) c.GetCurState(), telemetry::PackPosition(r.position.x, r.position.y),
+                                 (float) r.orientation);
+        }
+    }
+
+    /**
+     * 取出本帧所有机器人的控制指令，追加到instructions
+     */
+    void TakeInstructions(std::vector<Instruction>& instructions) {
         for (auto& c: controllers) {
             instructions.insert(instructions.end(),
                                 c.GetInstructionCache().begin(), c.GetInstructionCache().end());
             c.ClearInstructionCache();
         }
+    }
+
+    /**
+     * 获取输出的控制指令
+     * @return
+     */
+    std::string GetOutput() {
+        std::vector<Instruction> instructions;
+        TakeInstructions(instructions);
         std::string temp;
         for (auto& i: instructions) {
             temp += i.ToString() + '\n';
         }
         return temp;
     }
+
+    /**
+     * 输出结束报告（状态机统计）
+     * @param os 输出流
+     */
+    void Report(std::ostream& os) const {
+        for (const auto& c: controllers) {
+            os << "Robot No." << c.RobotIndex() << " final state " << ToString(c.GetCurState()) << "\n\t"
+               << c.GetProfile() << "\n";
+        }
+        os << "GridMap " << game.grid->GetStats() << "\n";
+        if (game.tt != nullptr) {
+            os << "TranspositionTable " << game.tt->GetStats() << "\n";
+        }
+        os << "EtaModel " << *game.eta << "\n";
+        os << "Lag " << game.lag->GetStats() << "\n";
+        os << "Motion " << game.motion->GetStats() << "\n";
+        os << "Reservation " << game.reservations->GetStats() << "\n";
+        os << "Fleet\n";
+        game.analytics->Summary(os);
+        if (game.assigner->GetPlanner() != nullptr) {
+            os << "MCTS " << game.assigner->GetPlanner()->GetStats() << "\n";
+        }
+    }
 };
 
 #endif //CODECRAFTSDK_ROBOTCONTROL_HPP
@@ -0,0 +1,158 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_SPATIALINDEX_HPP
+#define CODECRAFTSDK_SPATIALINDEX_HPP
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Structure.hpp"
+#include "GlobalSetting.h"
+
+/**
+ * @brief 工作台的均匀网格索引
+ *
+ * 把50m×50m的场地划成边长SPATIAL_CELL_SIZE的格子，每个格子按工作台类型分桶。
+ * 工作台位置在比赛中不变，读取地图后建一次即可。
+ * 查询按直线距离从近到远一圈一圈地扩展格子，找到足够的结果并且更外圈不可能更近时停止，
+ * 只用来给打分挑候选，不考虑障碍物的绕行。
+ */
+class SpatialIndex {
+public:
+    static constexpr int TYPE_COUNT = 10;   // 下标即工作台类型，0不用
+    static constexpr int CELLS = (int) (Game::mapSize / global::SPATIAL_CELL_SIZE + 0.999);
+
+    /**
+     * 读取地图后调用
+     */
+    void Build(const std::vector<Worktop>& worktops) {
+        positions.clear();
+        buckets.assign(CELLS * CELLS, {});
+        typeCount.fill(0);
+        buyerTypes.fill(0);
+        producerTypes = 0;
+        for (int i = 0, n = (int) worktops.size(); i < n; i++) {
+            const Worktop& w = worktops[i];
+            positions.push_back(w.position);
+            buckets[CellOf(w.position)][w.type].push_back(i);
+            typeCount[w.type]++;
+            if (w.producingItemType != 0) {
+                producerTypes |= 1 << w.type;
+            }
+            for (int item = 1; item < TYPE_COUNT; item++) {
+                if (w.purchasingItemBits & (1 << item)) {
+                    buyerTypes[item] |= 1 << w.type;
+                }
+            }
+        }
+    }
+
+    /**
+     * @return 收购某种物品的工作台类型掩码（第t位表示类型t）
+     */
+    int BuyerTypes(int itemType) const {
+        return itemType > 0 && itemType < TYPE_COUNT ? buyerTypes[itemType] : 0;
+    }
+
+    /**
+     * @return 有产出的工作台类型掩码
+     */
+    int ProducerTypes() const {
+        return producerTypes;
+    }
+
+    /**
+     * @return 某类型的工作台数量
+     */
+    int Count(int type) const {
+        return typeCount[type];
+    }
+
+    /**
+     * 离某点最近的k个特定类型的工作台
+     * @param p 查询点
+     * @param type 工作台类型
+     * @param k 最多返回的个数
+     * @param accept 额外的筛选条件，参数为工作台序号
+     * @param out 结果按距离从近到远追加到末尾
+     */
+    template<class Pred>
+    void Nearest(const Point& p, int type, int k, Pred&& accept, std::vector<int>& out) const {
+        if (k <= 0 || typeCount[type] == 0) {
+            return;
+        }
+        const int cx = Clamp((int) (p.x / global::SPATIAL_CELL_SIZE));
+        const int cy = Clamp((int) (p.y / global::SPATIAL_CELL_SIZE));
+        std::vector<std::pair<double, int>> found;
+        int seen = 0;
+        for (int r = 0; r < CELLS; r++) {
+            for (int x = std::max(cx - r, 0); x <= std::min(cx + r, CELLS - 1); x++) {
+                for (int y = std::max(cy - r, 0); y <= std::min(cy + r, CELLS - 1); y++) {
+                    if (std::max(std::abs(x - cx), std::abs(y - cy)) != r) {
+                        continue;   // 只看第r圈
+                    }
+                    for (int i: buckets[x * CELLS + y][type]) {
+                        seen++;
+                        if (accept(i)) {
+                            double dx = positions[i].x - p.x, dy = positions[i].y - p.y;
+                            found.emplace_back(dx * dx + dy * dy, i);
+                        }
+                    }
+                }
+            }
+            if (seen == typeCount[type]) {
+                break;
+            }
+            // 第r+1圈以外的点至少相距r个格子边长
+            if ((int) found.size() >= k) {
+                std::nth_element(found.begin(), found.begin() + (k - 1), found.end());
+                double bound = r * global::SPATIAL_CELL_SIZE;
+                if (found[k - 1].first <= bound * bound) {
+                    break;
+                }
+            }
+        }
+        std::sort(found.begin(), found.end());
+        for (int i = 0; i < (int) found.size() && i < k; i++) {
+            out.push_back(found[i].second);
+        }
+    }
+
+    /**
+     * 对掩码中的每种类型分别取最近的k个，保证各类型都有候选
+     * @param typeMask 第t位表示类型t
+     */
+    template<class Pred>
+    std::vector<int> NearestByType(const Point& p, int typeMask, int k, Pred&& accept) const {
+        std::vector<int> res;
+        for (int t = 1; t < TYPE_COUNT; t++) {
+            if (typeMask & (1 << t)) {
+                Nearest(p, t, k, accept, res);
+            }
+        }
+        return res;
+    }
+
+private:
+    static int Clamp(int c) {
+        return std::min(std::max(c, 0), CELLS - 1);
+    }
+
+    static int CellOf(const Point& p) {
+        return Clamp((int) (p.x / global::SPATIAL_CELL_SIZE)) * CELLS +
+               Clamp((int) (p.y / global::SPATIAL_CELL_SIZE));
+    }
+
+    std::vector<Point> positions;
+    // buckets[格子][类型] = 工作台序号
+    std::vector<std::array<std::vector<int>, TYPE_COUNT>> buckets;
+    std::array<int, TYPE_COUNT> typeCount{};
+    std::array<int, TYPE_COUNT> buyerTypes{};
+    int producerTypes = 0;
+};
+
+#endif //CODECRAFTSDK_SPATIALINDEX_HPP
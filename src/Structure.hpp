@@ -15,6 +15,14 @@
 #include <ostream>
 #include <iostream>
 #include <unordered_set>
+#include <algorithm>
+#include <climits>
+
+#include "Zobrist.hpp"
+#include "EtaModel.hpp"
+#include "LagMonitor.hpp"
+#include "Telemetry.hpp"
+#include "Availability.hpp"
 
 
 /**
@@ -148,7 +156,24 @@ struct Robot {
 
     Point position;                             // 位置
 
-    explicit Robot(const Point& position) : position(position) {}
+    int index = 0;                              // 机器人序号
+    uint64_t zobrist = 0;                       // 本机器人对状态哈希的贡献
+
+    explicit Robot(const Point& position, int index = 0) : position(position), index(index) {
+        Rehash();
+    }
+
+    /**
+     * 重新计算哈希分量（位置按0.5m格子量化），不维护状态哈希时分量保持为0
+     */
+    void Rehash() {
+        if (!global::ZOBRIST_HASHING) {
+            return;
+        }
+        uint64_t cell = uint64_t(int(position.x / 0.5)) * 128 + uint64_t(int(position.y / 0.5));
+        zobrist = zobrist::Key(zobrist::RobotCell, index, cell) ^
+                  zobrist::Key(zobrist::RobotItem, index, carryingItemType);
+    }
 
     double ItemPrice() const {
         if (carryingItemType != 0) {
@@ -165,12 +190,14 @@ struct Robot {
 
     void SellItem() {
         carryingItemType = 0;
+        Rehash();
     }
 
     void BuyItem(int itemType) {
         carryingItemType = itemType;
         timeValueCoefficient = 1.0;
         collisionValueCoefficient = 1.0;
+        Rehash();
     }
 
     /**
@@ -265,6 +292,7 @@ struct Robot {
         this->velocity = velocity;
         this->orientation = orientation;
         this->position = position;
+        Rehash();
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Robot& robot) {
@@ -284,14 +312,17 @@ struct Worktop {
     bool productionStatus = false;      // 产品格状态, true为当前有产品，false为无产品
     int purchasingItemBits = 0;
     const int producingItemType;        // 产出的产品，0表示不产出
+    int index = 0;                      // 工作台序号
+    uint64_t zobrist = 0;               // 本工作台对状态哈希的贡献
 
 
-    WorktopType Config() const {
+    const WorktopType& Config() const {
         return worktopTypeDict.find(type)->second;
     }
 
-    Worktop(const Point& position, int type) : position(position), type(type),
-                                               producingItemType(Config().producingItem) {
+    Worktop(const Point& position, int type, int index = 0) : position(position), type(type),
+                                                              producingItemType(Config().producingItem),
+                                                              index(index) {
         for (auto i: Config().purchasingItemTypes) {
             purchasingItemBits |= (0x1 << i);
         }
@@ -299,6 +330,7 @@ struct Worktop {
         if (purchasingItemBits == 0) {
             remainingProductionTime = Config().workCycle;
         }
+        Rehash();
     }
 
     double ItemPrice() const {
@@ -328,6 +360,7 @@ struct Worktop {
             remainingProductionTime = Config().workCycle;
             materialStatus = 0;
         }
+        Rehash();
     }
 
     void SellItem() {
@@ -336,6 +369,19 @@ struct Worktop {
             remainingProductionTime = Config().workCycle;
             materialStatus = 0;
         }
+        Rehash();
+    }
+
+    /**
+     * 重新计算哈希分量，不维护状态哈希时分量保持为0
+     */
+    void Rehash() {
+        if (!global::ZOBRIST_HASHING) {
+            return;
+        }
+        zobrist = zobrist::Key(zobrist::WorktopMaterial, index, materialStatus) ^
+                  zobrist::Key(zobrist::WorktopProduct, index, productionStatus) ^
+                  zobrist::Key(zobrist::WorktopRemaining, index, remainingProductionTime + 1);
     }
 
     bool Interactable(const Robot& robot) const {
@@ -351,6 +397,7 @@ struct Worktop {
         this->remainingProductionTime = remainingProductionTime;
         this->materialStatus = materialStatus;
         this->productionStatus = productionStatus;
+        Rehash();
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Worktop& worktop) {
@@ -363,18 +410,90 @@ struct Worktop {
 
 class Game;
 
-extern std::vector<double> EstimateWorktops(const Game& gameStatus, const int robotIndex, int depth);
+struct GridMap;
+
+class SpatialIndex;
+
+class DemandModel;
+
+class MotionMonitor;
+
+class ReservationTable;
+
+class FleetAnalytics;
 
 struct Task {
     double score;
-    int worktopID;
+    int worktopID;      // 第一段的目标工作台
+    int sinkID = -1;    // 取货后送货的目标工作台，-1表示单段任务
 };
 
+extern std::vector<double> EstimateWorktops(const Game& gameStatus, const int robotIndex, int depth);
+
+extern std::vector<Task> EstimateTaskChains(const Game& gameStatus, const int robotIndex);
+
+extern bool InEndgame(const Game& gameStatus);
+
+class MCTSPlanner;
+
+extern std::vector<Task> PlanTasks(MCTSPlanner& planner, const Game& game, int robotId,
+                                   const std::vector<Task>& inFlight);
+
+extern void CommitTask(MCTSPlanner& planner, const Task& task);
+
 class Assigner {
 private:
+    // 每个工作台的格子数，格子0为产品格，1-7为对应物品的原材料格
+    static constexpr int SLOT_COUNT = 8;
+
     Game& game;
-    std::unordered_set<int> availableSet;
-    std::unordered_map<int, int> workDict;
+    // 预定计数，下标为 工作台序号 * SLOT_COUNT + 格子号
+    std::vector<int> reservations;
+    std::unordered_map<int, Task> workDict;
+    // 机器人持有的格子，第一段的格子在前
+    std::unordered_map<int, std::vector<int>> heldSlots;
+    // 非空时使用MCTS规划，否则使用贪心
+    MCTSPlanner* planner = nullptr;
+    // 各机器人在降级模式下最近一次两段任务的打分（已排序）及其帧号，有效期内复用，任务结束时作废
+    std::unordered_map<int, std::pair<int, std::vector<Task>>> chainCache;
+
+    static int ProductSlot(int worktopID) {
+        return worktopID * SLOT_COUNT;
+    }
+
+    static int MaterialSlot(int worktopID, int itemType) {
+        return worktopID * SLOT_COUNT + itemType;
+    }
+
+    /**
+     * 格子可同时被预定的次数，8、9号工作台的原材料即收即耗，不限制
+     */
+    int Capacity(int slot) const;
+
+    /**
+     * 任务需要预定的格子
+     */
+    std::vector<int> SlotsOf(int robotId, const Task& t) const;
+
+    bool Available(const std::vector<int>& slots) const {
+        for (auto slot: slots) {
+            if (reservations[slot] >= Capacity(slot)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @param source 任务来源，见telemetry::Kind::Task
+     */
+    Task Reserve(int robotId, const Task& t, const std::vector<int>& slots, int source);
+
+    void Release(int slot) {
+        if (reservations[slot] > 0) {
+            reservations[slot]--;
+        }
+    }
 
 public:
     explicit Assigner(Game& game) : game(game) {
@@ -386,75 +505,88 @@ public:
     void Init();
 
 
-    int Size() {
-        return (int) availableSet.size();
+    /**
+     * 选择任务规划器
+     * @param mcts MCTS规划器，nullptr表示使用贪心
+     */
+    void SetPlanner(MCTSPlanner* mcts) {
+        planner = mcts;
     }
 
-    /**
-     * 获取可用的任务
-     * @param robotId 机器人ID
-     * @return 若成功则返回score, worktopID，若失败则返回0.0, -1
-     */
-    Task AssignTask(int robotId) {
-        static auto GetSortedIndex = [](const std::vector<double>& scores) -> std::vector<int> {
-            int n = (int) scores.size();
-            std::vector<int> indexs(n);
-            for (int i = 0; i < n; i++) {
-                indexs[i] = i;
-            }
-            for (int i = 1; i < n; i++) {
-                int t = indexs[i];
-                int j = i;
-                while (j > 0 && scores[t] > scores[indexs[j - 1]]) {
-                    j--;
-                }
-                for (int k = i; k > j; k--) {
-                    indexs[k] = indexs[k - 1];
-                }
-                indexs[j] = t;
-            }
-            return indexs;
-        };
+    MCTSPlanner* GetPlanner() const {
+        return planner;
+    }
 
-        auto scores = EstimateWorktops(game, robotId, 0);
+    /**
+     * @return 工作台的产品格是否被robotId以外的机器人预定，被预定的产品要留给预定它的机器人
+     */
+    bool ProductReserved(int worktopID, int robotId) const {
+        const int slot = ProductSlot(worktopID);
+        int own = 0;
+        auto it = heldSlots.find(robotId);
+        if (it != heldSlots.end()) {
+            own = (int) std::count(it->second.begin(), it->second.end(), slot);
+        }
+        return reservations[slot] > own;
+    }
 
-#ifdef _DEBUG
-        std::cerr << "EstimateWorktops: " << std::endl;
-        for (int i = 0; i < (int) scores.size(); i++) {
-            std::cerr << "No." << i << " score is " << scores[i] << "  |  ";
+    /**
+     * @return 当前被预定的格子总数
+     */
+    int Size() {
+        int res = 0;
+        for (auto r: reservations) {
+            res += r;
         }
-#endif
+        return res;
+    }
 
-        auto sortedIndex = GetSortedIndex(scores);
+    /**
+     * 获取可用的任务，空手时优先分配“取货-送货”两段任务，按(工作台, 格子)预定
+     * @param robotId 机器人ID
+     * @return 若成功则返回score, worktopID, sinkID，若失败则返回0.0, -1
+     */
+    Task AssignTask(int robotId);
 
-#ifdef _DEBUG
-        std::cerr << "sortedIndex: " << std::endl;
-        for (auto i: sortedIndex) {
-            std::cerr << i << ' ';
+    /**
+     * 两段任务的取货段完成，释放取货工作台的产品格，送货格子仍保持预定
+     * @param robotId
+     * @return 送货工作台，-1表示没有第二段
+     */
+    int FinishLeg(int robotId) {
+        auto it = workDict.find(robotId);
+        if (it == workDict.end()) {
+            return -1;
         }
-        std::cerr << std::endl;
-#endif
-
-        for (auto i: sortedIndex) {
-            if (this->availableSet.find(i) != this->availableSet.end()) {
-                this->availableSet.erase(i);
-                this->workDict[robotId] = i;
-//                if (scores[i] < -500000.0) {
-//                    return -1;
-//                }
-                return {scores[i], i};
-            }
+        auto& slots = heldSlots[robotId];
+        if (!slots.empty()) {
+            Release(slots.front());
+            slots.erase(slots.begin());
         }
-        return {0.0, -1};
+        Task& t = it->second;
+        t.worktopID = t.sinkID;
+        t.sinkID = -1;
+        if (t.worktopID == -1) {
+            TaskOver(robotId);
+            return -1;
+        }
+        return t.worktopID;
     }
 
     /**
-     * 当前任务结束（不管是否成功）
+     * 当前任务结束（不管是否成功），释放所有持有的格子
      * @param robotId
      */
     void TaskOver(int robotId) {
-        this->availableSet.insert(this->workDict[robotId]);
-        this->workDict.erase(robotId);
+        auto it = heldSlots.find(robotId);
+        if (it != heldSlots.end()) {
+            for (auto slot: it->second) {
+                Release(slot);
+            }
+            heldSlots.erase(it);
+        }
+        workDict.erase(robotId);
+        chainCache.erase(robotId);
     }
 
 };
@@ -469,45 +601,187 @@ struct Game {
     std::vector<Robot> robots;
     std::vector<Worktop> worktops;
 
+    // 状态哈希（机器人位置与物品、工作台格子、金钱），随状态增量维护，不含帧号；ZOBRIST_HASHING为false时不维护
+    uint64_t hash = zobrist::Key(zobrist::Money, 0, 0);
+
+    // 各物品可买的生产者与可卖的消费者，随工作台状态增量维护
+    AvailabilityIndex availability;
+
     Assigner* assigner;
 
-    Game() : assigner(new Assigner(*this)) {}
+    // 占据栅格与距离场，只读，所有副本共享同一份
+    GridMap* grid;
+
+    // 子树最优值的置换表，所有副本共享同一份；只在SEARCH_DEPTH大于0时创建，否则为nullptr
+    TranspositionTable* tt;
+
+    // 在线校准的行程帧数模型，所有副本共享同一份
+    EtaModel* eta;
+
+    // 掉帧检测，所有副本共享同一份
+    LagMonitor* lag;
+
+    // 遥测缓冲区，所有副本共享同一份
+    telemetry::RingBuffer* telemetry;
+
+    // 工作台空间索引，只读，所有副本共享同一份
+    SpatialIndex* spatial;
+
+    // 按需生产的需求，每帧按真实局面更新，所有副本共享同一份
+    DemandModel* demand;
+
+    // 机器人运动历史与卡住检测，只记录真实局面，所有副本共享同一份
+    MotionMonitor* motion;
+
+    // 多机器人协同路线的时空预定表，所有副本共享同一份
+    ReservationTable* reservations;
+
+    // 机器人利用率与生产阻塞的统计，只记录真实局面，所有副本共享同一份
+    FleetAnalytics* analytics;
+
+    Game();
 
     Game(const Game& other) : curFrame(other.curFrame), money(other.money), robots(other.robots),
-                              worktops(other.worktops), assigner(nullptr) {}
+                              worktops(other.worktops), hash(other.hash),
+                              availability(other.availability), assigner(nullptr), grid(other.grid),
+                              tt(other.tt), eta(other.eta),
+                              lag(other.lag), telemetry(other.telemetry),
+                              spatial(other.spatial), demand(other.demand),
+                              motion(other.motion), reservations(other.reservations),
+                              analytics(other.analytics) {}
+
+    /**
+     * 含帧号的状态键，用于查询置换表
+     */
+    uint64_t Key() const {
+        return hash ^ zobrist::Key(zobrist::Frame, 0, curFrame);
+    }
+
+    /**
+     * 把哈希分量并入或移出状态哈希
+     */
+    void ToggleHash(uint64_t component) {
+        if (global::ZOBRIST_HASHING) {
+            hash ^= component;
+        }
+    }
 
+    /**
+     * 修改金钱并维护哈希
+     */
+    void SetMoney(int value) {
+        if (global::ZOBRIST_HASHING) {
+            hash ^= zobrist::Key(zobrist::Money, 0, (uint32_t) money) ^
+                    zobrist::Key(zobrist::Money, 0, (uint32_t) value);
+        }
+        money = value;
+    }
 
     /**
-     * 初始化，读取地图后调用
+     * 试探性修改的撤销点，覆盖帧号、金钱、一个机器人和一个工作台。
+     * 评估只改动这些状态时，用它代替复制整个游戏状态
      */
-    void Init() {
-        assigner->Init();
+    struct Savepoint {
+        int curFrame;
+        int money;
+        uint64_t hash;
+        int robotIndex;
+        Robot robot;
+        int worktopIndex;
+        int remainingProductionTime;
+        int materialStatus;
+        bool productionStatus;
+        uint64_t worktopZobrist;
+    };
+
+    Savepoint Save(int robotIndex, int worktopIndex) const {
+        const Worktop& w = worktops[worktopIndex];
+        return {curFrame, money, hash, robotIndex, robots[robotIndex], worktopIndex, w.remainingProductionTime,
+                w.materialStatus, w.productionStatus, w.zobrist};
     }
 
+    void Rollback(const Savepoint& s) {
+        curFrame = s.curFrame;
+        money = s.money;
+        hash = s.hash;
+        robots[s.robotIndex] = s.robot;
+        Worktop& w = worktops[s.worktopIndex];
+        w.remainingProductionTime = s.remainingProductionTime;
+        w.materialStatus = s.materialStatus;
+        w.productionStatus = s.productionStatus;
+        w.zobrist = s.worktopZobrist;
+        Reindex(s.worktopIndex);
+    }
+
+    /**
+     * 按工作台当前的产品格与原料格更新可用性索引
+     * @param worktopIndex 工作台序号
+     */
+    void Reindex(int worktopIndex) {
+        const Worktop& w = worktops[worktopIndex];
+        if (w.producingItemType != 0) {
+            availability.Set(AvailabilityIndex::Ready, w.producingItemType, worktopIndex, w.productionStatus);
+        }
+        for (int bits = w.purchasingItemBits; bits != 0; bits &= bits - 1) {
+            const int item = __builtin_ctz(bits);
+            availability.Set(AvailabilityIndex::Open, item, worktopIndex, (w.materialStatus & (1 << item)) == 0);
+        }
+    }
+
+
+    /**
+     * 初始化，读取地图后调用（定义于GridMap.hpp）
+     */
+    void Init();
+
+    /**
+     * 释放构造时创建的共享对象，只能由构造出它们的状态调用一次，副本不能调用（定义于GridMap.hpp）
+     */
+    void Release();
+
     /**s
      * 刷新工作台在特定帧数后的状态
      * @param frames 帧数
      */
     void UpdateWorktops(int frames) {
-        for (Worktop& w: worktops) {
-            if (w.remainingProductionTime > frames) {
-                w.remainingProductionTime -= frames;
-            } else if (w.remainingProductionTime != -1) {
-                w.remainingProductionTime = 0;
-            }
-            // 若当前产品格为空则刷新产品格
-            if (w.remainingProductionTime == 0) {
-                if (!w.productionStatus) {
-                    w.productionStatus = true;
-                    w.remainingProductionTime = -1;
-                }
+        for (int i = 0, n = (int) worktops.size(); i < n; i++) {
+            UpdateWorktop(i, frames);
+        }
+    }
+
+    /**
+     * 只刷新一个工作台在特定帧数后的状态，用于只关心目标工作台的评估
+     * @param worktopIndex 工作台序号
+     * @param frames 帧数
+     */
+    void UpdateWorktop(int worktopIndex, int frames) {
+        Worktop& w = worktops[worktopIndex];
+        const int remaining = w.remainingProductionTime;
+        const bool product = w.productionStatus;
+        if (w.remainingProductionTime > frames) {
+            w.remainingProductionTime -= frames;
+        } else if (w.remainingProductionTime != -1) {
+            w.remainingProductionTime = 0;
+        }
+        // 若当前产品格为空则刷新产品格
+        if (w.remainingProductionTime == 0) {
+            if (!w.productionStatus) {
+                w.productionStatus = true;
+                w.remainingProductionTime = -1;
             }
-            if (w.materialStatus == w.purchasingItemBits) {
-                if (!w.productionStatus) {
-                    w.remainingProductionTime = w.Config().workCycle;
-                }
+        }
+        if (w.materialStatus == w.purchasingItemBits) {
+            if (!w.productionStatus) {
+                w.remainingProductionTime = w.Config().workCycle;
             }
         }
+        // 大部分工作台状态不变，不必重算哈希
+        if (w.remainingProductionTime != remaining || w.productionStatus != product) {
+            ToggleHash(w.zobrist);
+            w.Rehash();
+            ToggleHash(w.zobrist);
+            Reindex(worktopIndex);
+        }
     }
 
 
@@ -519,16 +793,20 @@ struct Game {
     void TryDoTrade(const int& robotID, const int& worktopID) {
         Worktop& worktop = worktops[worktopID];
         Robot& robot = robots[robotID];
+        ToggleHash(worktop.zobrist ^ robot.zobrist);
         if (worktop.ItemAcceptable(robot.carryingItemType)) {
             worktop.AcceptItem(robot.carryingItemType);
+            // 先结算售价再清空携带物品
+            SetMoney(money + (int) robot.ItemPrice());
             robot.SellItem();
-            money += (int) robot.ItemPrice();
         }
         if (worktop.productionStatus && money > worktop.ItemPrice() && robot.carryingItemType == 0) {
             worktop.SellItem();
             robot.BuyItem(worktop.producingItemType);
-            money -= (int) worktop.ItemPrice();
+            SetMoney(money - (int) worktop.ItemPrice());
         }
+        ToggleHash(worktop.zobrist ^ robot.zobrist);
+        Reindex(worktopID);
     }
 
     void ApplySelection(const int& robotIndex, const int& worktopIndex) {
@@ -536,7 +814,10 @@ struct Game {
         Worktop& curWorktop = worktops[worktopIndex];
 
         curRobot.orientation = Direction(curRobot.position, curWorktop.position);
+        ToggleHash(curRobot.zobrist);
         curRobot.position = curWorktop.position;
+        curRobot.Rehash();
+        ToggleHash(curRobot.zobrist);
         TryDoTrade(robotIndex, worktopIndex);
     }
 
@@ -550,7 +831,8 @@ struct Game {
      * 坐标为：(0.25,49.75)。
      */
     void LoadRobot(double x, double y) {
-        robots.emplace_back(Point(x, y));
+        robots.emplace_back(Point(x, y), (int) robots.size());
+        ToggleHash(robots.back().zobrist);
     }
 
     /**
@@ -564,11 +846,25 @@ struct Game {
      * 坐标为：(0.25,49.75)。
      */
     void LoadWorktop(double x, double y, int type) {
-        worktops.emplace_back(Point(x, y), type);
+        worktops.emplace_back(Point(x, y), type, (int) worktops.size());
+        ToggleHash(worktops.back().zobrist);
+        availability.Grow((int) worktops.size());
+        Reindex((int) worktops.size() - 1);
     }
 
+    /**
+     * @brief 为地图添加障碍（定义于GridMap.hpp）
+     * @param row 地图文本的行号
+     * @param col 地图文本的列号
+     */
+    void LoadObstacle(int row, int col);
+
     void RefreshCurrentFrameID(int frameID) {
         this->curFrame = frameID;
+        lag->BeginFrame(frameID);
+        if (tt != nullptr) {
+            tt->NewFrame();
+        }
     }
 
     /**
@@ -576,7 +872,7 @@ struct Game {
      * @param money 当前金钱数
      */
     void RefreshCurrentMoney(int curmoney) {
-        this->money = curmoney;
+        SetMoney(curmoney);
     }
 
     /**
@@ -591,7 +887,11 @@ struct Game {
      */
     void RefreshWorktopStatus(int index, int type, double x, double y, int remainingProductionTime, int materialStatus,
                               int productionStatus) {
+        ToggleHash(worktops[index].zobrist);
         worktops[index].Refresh(type, Point(x, y), remainingProductionTime, materialStatus, productionStatus);
+        ToggleHash(worktops[index].zobrist);
+        Reindex(index);
+        RecordWorktop(index);
     }
 
     /**
@@ -613,10 +913,25 @@ struct Game {
                        double palstance,
                        double vx,
                        double vy, double orientation, double x, double y) {
+        ToggleHash(robots[index].zobrist);
         robots[index].Refresh(worktopID, carryingItemType, timeCof, collusionCof,
                               palstance, Vector2d(vx, vy), orientation, Point(x, y));
+        ToggleHash(robots[index].zobrist);
+        RecordRobot(index);
     }
 
+    /**
+     * @brief 把机器人本帧的状态记入运动历史与运营统计（定义于GridMap.hpp）
+     * @param index 机器人序号
+     */
+    void RecordRobot(int index);
+
+    /**
+     * @brief 把工作台本帧的状态记入运营统计（定义于GridMap.hpp）
+     * @param index 工作台序号
+     */
+    void RecordWorktop(int index);
+
 
     friend std::ostream& operator<<(std::ostream& os, const Game& game) {
         os << "curFrame: " << game.curFrame << " money: " << game.money << "\nRobots:\n";
@@ -635,11 +950,154 @@ struct Game {
     }
 };
 
+inline Task Assigner::Reserve(int robotId, const Task& t, const std::vector<int>& slots, int source) {
+    std::vector<int> held = slots;
+    // 单段送货卖出后会顺手买入目标工作台的产品，产品格空着时一并预定，避免被其它机器人同时计划买走
+    const int product = ProductSlot(t.worktopID);
+    if (t.sinkID == -1 && game.robots[robotId].carryingItemType != 0 && held.front() != product &&
+        game.worktops[t.worktopID].producingItemType != 0 && reservations[product] < Capacity(product)) {
+        held.push_back(product);
+    }
+    for (auto slot: held) {
+        reservations[slot]++;
+    }
+    heldSlots[robotId] = held;
+    workDict[robotId] = t;
+    game.telemetry->Push(game.curFrame, telemetry::Kind::Task, robotId, source, 0,
+                         telemetry::PackTask(t.worktopID, t.sinkID), (float) t.score);
+    return t;
+}
+
+inline Task Assigner::AssignTask(int robotId) {
+    static auto GetSortedIndex = [](const std::vector<double>& scores) -> std::vector<int> {
+        int n = (int) scores.size();
+        std::vector<int> indexs(n);
+        for (int i = 0; i < n; i++) {
+            indexs[i] = i;
+        }
+        for (int i = 1; i < n; i++) {
+            int t = indexs[i];
+            int j = i;
+            while (j > 0 && scores[t] > scores[indexs[j - 1]]) {
+                j--;
+            }
+            for (int k = i; k > j; k--) {
+                indexs[k] = indexs[k - 1];
+            }
+            indexs[j] = t;
+        }
+        return indexs;
+    };
+
+    if (planner != nullptr) {
+        std::vector<Task> inFlight(game.robots.size(), Task{0.0, -1, -1});
+        for (const auto& w: workDict) {
+            inFlight[w.first] = w.second;
+        }
+        for (const auto& t: PlanTasks(*planner, game, robotId, inFlight)) {
+            if (t.worktopID == -1) {
+                continue;
+            }
+            auto slots = SlotsOf(robotId, t);
+            if (Available(slots)) {
+                CommitTask(*planner, t);
+                return Reserve(robotId, t, slots, 2);
+            }
+        }
+        // 没有搜索预算或搜索结果都被占用时退回贪心
+    }
+
+    // 两段任务只给空手的机器人；降级模式下在有效期内复用上次的打分，只重新检查预定，
+    // 缓存只在降级模式下写入，任务结束时作废
+    if (game.robots[robotId].carryingItemType == 0) {
+        std::vector<Task> fresh;
+        const std::vector<Task>* chains = &fresh;
+        auto cached = chainCache.find(robotId);
+        if (game.lag->Degraded() && cached != chainCache.end() &&
+            game.curFrame - cached->second.first <= global::LAG_SCORE_CACHE_FRAMES) {
+            chains = &cached->second.second;
+            game.lag->SkipDecision();
+        } else {
+            fresh = EstimateTaskChains(game, robotId);
+            std::stable_sort(fresh.begin(), fresh.end(), [](const Task& a, const Task& b) {
+                return a.score > b.score;
+            });
+            if (game.lag->Degraded()) {
+                auto& cache = chainCache[robotId];
+                cache.first = game.curFrame;
+                cache.second = std::move(fresh);
+                chains = &cache.second;
+            }
+        }
+        for (const auto& t: *chains) {
+            auto slots = SlotsOf(robotId, t);
+            if (Available(slots)) {
+                return Reserve(robotId, t, slots, 1);
+            }
+        }
+    }
+
+    // 终局阶段空手的机器人只接受完整的两段任务，避免买入后来不及卖出
+    if (game.robots[robotId].carryingItemType == 0 && InEndgame(game)) {
+        return {0.0, -1, -1};
+    }
+
+    auto scores = EstimateWorktops(game, robotId, 0);
+
+#ifdef _DEBUG
+    std::cerr << "EstimateWorktops: " << std::endl;
+    for (int i = 0; i < (int) scores.size(); i++) {
+        std::cerr << "No." << i << " score is " << scores[i] << "  |  ";
+    }
+#endif
+
+    auto sortedIndex = GetSortedIndex(scores);
+
+#ifdef _DEBUG
+    std::cerr << "sortedIndex: " << std::endl;
+    for (auto i: sortedIndex) {
+        std::cerr << i << ' ';
+    }
+    std::cerr << std::endl;
+#endif
+
+    for (auto i: sortedIndex) {
+        Task t{scores[i], i, -1};
+        auto slots = SlotsOf(robotId, t);
+        if (Available(slots)) {
+            return Reserve(robotId, t, slots, 0);
+        }
+    }
+    return {0.0, -1, -1};
+}
+
 inline void Assigner::Init() {
-    this->availableSet = std::unordered_set<int>();
-    for (int i = 0; i < (int) game.worktops.size(); i++) {
-        this->availableSet.insert(i);
+    this->reservations.assign(game.worktops.size() * SLOT_COUNT, 0);
+    this->workDict.clear();
+    this->heldSlots.clear();
+}
+
+inline int Assigner::Capacity(int slot) const {
+    const Worktop& w = game.worktops[slot / SLOT_COUNT];
+    if (slot % SLOT_COUNT != 0 && w.producingItemType == 0) {
+        return INT_MAX;
+    }
+    return 1;
+}
+
+inline std::vector<int> Assigner::SlotsOf(int robotId, const Task& t) const {
+    std::vector<int> res;
+    const int carrying = game.robots[robotId].carryingItemType;
+    const Worktop& first = game.worktops[t.worktopID];
+    if (carrying != 0 && (first.purchasingItemBits & (1 << carrying)) != 0) {
+        res.push_back(MaterialSlot(t.worktopID, carrying));
+    } else {
+        res.push_back(ProductSlot(t.worktopID));
+    }
+    if (t.sinkID != -1) {
+        res.push_back(MaterialSlot(t.sinkID, first.producingItemType));
     }
+    return res;
 }
 
 
@@ -0,0 +1,118 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_TELEMETRY_HPP
+#define CODECRAFTSDK_TELEMETRY_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "GlobalSetting.h"
+
+/**
+ * @brief 二进制遥测
+ *
+ * 运行时只往固定大小的环形缓冲区里写定长记录，不做任何格式化，缓冲区满了覆盖最旧的记录。
+ * 结束时整块写入文件，由 tools/TelemetryDecoder 离线解析。
+ */
+namespace telemetry {
+    enum class Kind : uint8_t {
+        Frame = 1,      // a: 是否降级 b: 本帧之前跳过的帧数 x: 金钱 y: 上一帧处理时间（毫秒）
+        Robot,          // a: 携带物品 b: 状态 x: 坐标（x、y各乘100，低16位为x） y: 朝向
+        Task,           // a: 来源（0贪心 1两段 2MCTS） x: 工作台（低16位）与送货工作台+1（高16位） y: 分数
+        Transition,     // a: 原状态 b: 新状态 x: 事件序号 y: 未使用
+    };
+
+    // 16字节定长记录
+    struct Record {
+        int32_t frame;
+        Kind kind;
+        uint8_t robot;
+        uint8_t a;
+        uint8_t b;
+        int32_t x;
+        float y;
+    };
+    static_assert(sizeof(Record) == 16, "telemetry record must stay 16 bytes");
+
+    // 文件头，记录按时间顺序紧随其后
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t count;         // 文件中的记录数
+        uint64_t total;         // 运行期间写入的记录总数，大于count说明最早的记录已被覆盖
+    };
+
+    static constexpr char MAGIC[4] = {'C', 'C', 'T', 'L'};
+    static constexpr uint32_t VERSION = 2;
+
+    inline int32_t PackPosition(double x, double y) {
+        return (int32_t) ((uint32_t) (x * 100.0) & 0xffffu) | (int32_t) (((uint32_t) (y * 100.0) & 0xffffu) << 16);
+    }
+
+    inline void UnpackPosition(int32_t packed, double& x, double& y) {
+        x = (double) ((uint32_t) packed & 0xffffu) / 100.0;
+        y = (double) (((uint32_t) packed >> 16) & 0xffffu) / 100.0;
+    }
+
+    /**
+     * 任务的两个工作台，sink为-1表示没有第二段
+     */
+    inline int32_t PackTask(int worktop, int sink) {
+        return (int32_t) (((uint32_t) worktop & 0xffffu) | (((uint32_t) (sink + 1) & 0xffffu) << 16));
+    }
+
+    inline void UnpackTask(int32_t packed, int& worktop, int& sink) {
+        worktop = (int) ((uint32_t) packed & 0xffffu);
+        sink = (int) (((uint32_t) packed >> 16) & 0xffffu) - 1;
+    }
+
+    class RingBuffer {
+    public:
+        explicit RingBuffer(int sizeLog2) : records(size_t(1) << sizeLog2), mask((size_t(1) << sizeLog2) - 1) {}
+
+        void Push(int frame, Kind kind, int robot, int a, int b, int32_t x, float y) {
+            Record& r = records[head & mask];
+            r.frame = frame;
+            r.kind = kind;
+            r.robot = (uint8_t) robot;
+            r.a = (uint8_t) a;
+            r.b = (uint8_t) b;
+            r.x = x;
+            r.y = y;
+            head++;
+        }
+
+        uint64_t Total() const {
+            return head;
+        }
+
+        /**
+         * 按时间顺序写入文件
+         * @return 是否成功
+         */
+        bool Dump(const char* path) const {
+            FILE* f = fopen(path, "wb");
+            if (f == nullptr) {
+                return false;
+            }
+            uint64_t count = head < records.size() ? head : records.size();
+            Header h{{MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]}, VERSION, sizeof(Record), (uint32_t) count, head};
+            bool ok = fwrite(&h, sizeof h, 1, f) == 1;
+            for (uint64_t i = head - count; ok && i < head; i++) {
+                ok = fwrite(&records[i & mask], sizeof(Record), 1, f) == 1;
+            }
+            return fclose(f) == 0 && ok;
+        }
+
+    private:
+        std::vector<Record> records;
+        size_t mask;
+        uint64_t head = 0;
+    };
+}
+
+#endif //CODECRAFTSDK_TELEMETRY_HPP
@@ -0,0 +1,130 @@
+//
+// header only
+//
+
+#ifndef CODECRAFTSDK_ZOBRIST_HPP
+#define CODECRAFTSDK_ZOBRIST_HPP
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+
+/**
+ * @brief 规划状态的Zobrist哈希
+ *
+ * 每个(分量, 下标, 取值)对应一个伪随机64位键，状态哈希为所有分量键的异或。
+ * 键由splitmix64即时算出，不需要预先生成按地图大小变化的随机表。
+ * 只有置换表使用状态哈希，SEARCH_DEPTH为0时（global::ZOBRIST_HASHING为false）各分量不计算、不维护。
+ */
+namespace zobrist {
+    enum Domain : uint64_t {
+        RobotCell = 1,          // 机器人所在格子
+        RobotItem,              // 机器人携带物品
+        WorktopMaterial,        // 原材料格状态
+        WorktopProduct,         // 产品格状态
+        WorktopRemaining,       // 剩余生产时间
+        Money,                  // 金钱
+        Frame,                  // 帧号
+        Depth,                  // 搜索深度
+        ValueCoefficient,       // 携带物品的价值系数
+    };
+
+    inline uint64_t Mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    inline uint64_t Key(Domain domain, uint64_t index, uint64_t value) {
+        return Mix((uint64_t(domain) << 56) ^ (index << 36) ^ value);
+    }
+}
+
+/**
+ * @brief 固定大小的置换表，缓存规划状态的估值
+ *
+ * 直接映射，每个表项24字节，估值按double原样保存；跨帧保留，按代数与深度决定替换。
+ * 只用于多层搜索（SEARCH_DEPTH大于0）的子树最优值，SEARCH_DEPTH为0时不创建。
+ */
+class TranspositionTable {
+public:
+    struct Stats {
+        long long probes = 0;
+        long long hits = 0;
+        long long stores = 0;
+        long long overwrites = 0;   // 覆盖了其它状态的表项
+
+        double HitRate() const {
+            return probes == 0 ? 0.0 : (double) hits / (double) probes;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Stats& s) {
+            os << "probes: " << s.probes << " hits: " << s.hits << " hitRate: " << s.HitRate()
+               << " stores: " << s.stores << " overwrites: " << s.overwrites;
+            return os;
+        }
+    };
+
+    explicit TranspositionTable(int sizeLog2) : mask((1ULL << sizeLog2) - 1), entries(1ULL << sizeLog2) {}
+
+    /**
+     * 查询
+     * @param key 状态哈希
+     * @param depth 需要的最小剩余深度
+     * @param value 命中时写入估值
+     * @return 是否命中
+     */
+    bool Probe(uint64_t key, int depth, double& value) {
+        stats.probes++;
+        const Entry& e = entries[key & mask];
+        if (e.key == key && e.depth >= depth) {
+            stats.hits++;
+            value = e.value;
+            return true;
+        }
+        return false;
+    }
+
+    void Store(uint64_t key, int depth, double value) {
+        Entry& e = entries[key & mask];
+        if (e.key != key && e.key != 0) {
+            // 同代更深的结果优先保留
+            if (e.generation == generation && e.depth > depth) {
+                return;
+            }
+            stats.overwrites++;
+        }
+        stats.stores++;
+        e.key = key;
+        e.value = value;
+        e.depth = (int16_t) depth;
+        e.generation = generation;
+    }
+
+    /**
+     * 每帧调用一次，旧表项变为可替换
+     */
+    void NewFrame() {
+        generation++;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        double value = 0.0;
+        int16_t depth = 0;
+        uint16_t generation = 0;
+    };
+
+    uint64_t mask;
+    std::vector<Entry> entries;
+    uint16_t generation = 0;
+    Stats stats;
+};
+
+#endif //CODECRAFTSDK_ZOBRIST_HPP
@@ -6,10 +6,13 @@
 #include <cassert>
 #include <sstream>
 #include <fstream>
-#include "RobotControl.hpp"
+#include "Engine.hpp"
+#include "Protocol.hpp"
+#include "CaptureWriter.hpp"
+#include "PerfCounters.hpp"
 
 
-#ifdef _DEBUG
+#if defined(_DEBUG) && defined(_WIN32)
 
 #include <windows.h>
 
@@ -19,10 +22,6 @@
 using namespace std;
 
 
-Game game;
-
-GeneralController generalController(game);
-
 bool readUntilOK() {
     char line[1024];
     while (fgets(line, sizeof line, stdin)) {
@@ -35,122 +34,111 @@ bool readUntilOK() {
 }
 
 
-bool LoadMap() {
+/**
+ * 从标准输入读取到OK行为止（含OK行）的原始文本，地图与每一帧都以OK行结束
+ * @return 是否读到了数据
+ */
+bool ReadBlock(string& text) {
+    text.clear();
     char line[1025];
-    int row = 0;
-    bool suc = false;
-    while (fgets(line, 1025, stdin)) {
+    while (fgets(line, sizeof line, stdin)) {
+        text += line;
         if (line[0] == 'O' && line[1] == 'K') {
-            suc = true;
             break;
         }
-        for (int i = 0, n = strlen(line); i < n; i++) {
-            switch (line[i]) {
-                case '.':
-                    break;
-                case 'A':
-                    game.LoadRobot(0.25 + 0.5 * i, 49.75 - 0.5 * row);
-                    break;
-                case '1':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 1);
-                    break;
-                case '2':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 2);
-                    break;
-                case '3':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 3);
-                    break;
-                case '4':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 4);
-                    break;
-                case '5':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 5);
-                    break;
-                case '6':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 6);
-                    break;
-                case '7':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 7);
-                    break;
-                case '8':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 8);
-                    break;
-                case '9':
-                    game.LoadWorktop(0.25 + 0.5 * i, 49.75 - 0.5 * row, 9);
-                    break;
-                default:
-                    break;
-            }
-        }
-        row++;
-    };
-    return suc;
+    }
+    return !text.empty();
 }
 
-bool LoadFrame() {
-    int currentMoney;
-    int K;
-    int worktopType;
-    double worktopPosx, worktopPosy;
-    int remainingProductionTime, materialStatus, productionStatus;
-    scanf(  // frameID已经被读取
-            "%d "
-            "%d ", &currentMoney, &K);
-    for (int i = 0; i < K; i++) {
-        scanf("%d %lf %lf %d %d %d", &worktopType, &worktopPosx, &worktopPosy,
-              &remainingProductionTime, &materialStatus, &productionStatus);
-        game.RefreshWorktopStatus(i, worktopType, worktopPosx, worktopPosy, remainingProductionTime, materialStatus,
-                                  productionStatus);
+
+int main(int argc, char** argv) {
+    // -p mcts 使用MCTS规划器，默认为贪心
+    // -t <文件> 结束时遥测的输出位置
+    // -c <文件> 把收到的原始输入（地图与每一帧）抓包到文件，可用 capture_replayer 回放
+    // -k <目录> 距离场等预计算的缓存目录，默认为log，目录不存在时不缓存
+    // -P 按解析、决策、输出三个阶段统计硬件性能计数器（仅Linux），结果附在结束报告中
+    Engine engine;
+    CaptureWriter capture;
+    PerfCounters perf;
+    bool perfEnabled = false;
+    const char* telemetryPath = "log/telemetry.bin";
+    const char* cacheDir = "log";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-P") == 0) {
+            perfEnabled = true;
+        } else if (i + 1 == argc) {
+            break;
+        } else if (strcmp(argv[i], "-p") == 0 && strcmp(argv[i + 1], "mcts") == 0) {
+            engine.SetPlanner(make_unique<MCTSPlanner>());
+        } else if (strcmp(argv[i], "-t") == 0) {
+            telemetryPath = argv[i + 1];
+        } else if (strcmp(argv[i], "-k") == 0) {
+            cacheDir = argv[i + 1];
+        } else if (strcmp(argv[i], "-c") == 0 && !capture.Open(argv[i + 1])) {
+            cerr << "cannot open capture " << argv[i + 1] << "\n";
+        }
     }
-    int curWorktopID, carryingItemType;
-    double timeValueCoefficient, collisionValueCoefficient;
-    double palstance, vx, vy, orientation;
-    double px, py;
-    for (int i = 0; i < 4; i++) {
-        scanf("%d %d %lf %lf %lf %lf %lf %lf %lf %lf", &curWorktopID, &carryingItemType,
-              &timeValueCoefficient, &collisionValueCoefficient, &palstance,
-              &vx, &vy, &orientation, &px, &py);
-        game.RefreshRobotStatus(i, curWorktopID, carryingItemType, timeValueCoefficient, collisionValueCoefficient,
-                                palstance, vx, vy, orientation, px, py);
+    if (perfEnabled) {
+        perf.Open();
     }
-    char temp[1024];
-    scanf("%s", temp);
-
-#ifdef _DEBUG
-
-#endif
-    return strcmp(temp, "OK") == 0;
-}
-
+    engine.SetCacheDir(cacheDir);
 
-int main() {
-    LoadMap();
+    string text;
+    ReadBlock(text);
+    capture.Append(text);
+    // 距离场等预计算在回复OK之前完成
+    engine.LoadMap(text);
     puts("OK");
     fflush(stdout);
-    generalController.Init();
     long long frameCount = 0;
-    int frameID;
-    game.Init();
-    while (scanf("%d", &frameID) != EOF) {
-
-#ifdef _DEBUG
-#endif
-
-        game.RefreshCurrentFrameID(frameID);
-        LoadFrame();
-        generalController.Update();
-        printf("%d\n", frameID);
-        string cache = generalController.GetOutput();
-        cout << cache;
+    long long malformedFrames = 0;
+    Engine::Frame frame;
+    while (ReadBlock(text)) {
+        // 等待判题器输入的时间不计入
+        perf.Start();
+        capture.Append(text);
+        string_view view(text);
+        frame.frameID = -1;
+        const bool parsed = protocol::ParseFrame(view, frame, engine.RobotCount());
+        perf.Lap(PerfCounters::Parse);
+        if (!parsed) {
+            // 残缺的帧不交给引擎：读到了帧号就回复一个空帧，连帧号都没有则结束
+            malformedFrames++;
+            if (frame.frameID < 0) {
+                break;
+            }
+            printf("%d\nOK\n", frame.frameID);
+            fflush(stdout);
+            continue;
+        }
+        const auto& instructions = engine.Step(frame);
+        perf.Lap(PerfCounters::Update);
+        printf("%d\n", frame.frameID);
+        for (const auto& i: instructions) {
+            fputs(i.ToString().c_str(), stdout);
+            putchar('\n');
+        }
         printf("OK\n");
 
         fflush(stdout);
-
-#ifdef _DEBUG
-#endif
+        engine.EndFrame();
+        perf.Lap(PerfCounters::Output);
 
         frameCount++;
     }
+    capture.Close();
+
+    // 结束报告输出到stderr，不影响判题器读取
+    cerr << "frames: " << frameCount << " malformed: " << malformedFrames << "\n";
+    engine.Report(cerr);
+    cerr << "telemetry: " << engine.TelemetryTotal() << " records "
+         << (engine.DumpTelemetry(telemetryPath) ? "written to " : "not written to ") << telemetryPath << "\n";
+    if (capture.Total() > 0) {
+        cerr << "capture: " << capture.Total() << " bytes\n";
+    }
+    if (perfEnabled) {
+        cerr << perf;
+    }
 
     return 0;
 }
@@ -0,0 +1,142 @@
+//
+// 批量评估：每张地图开若干局，每局一个决策引擎实例，所有对局在同一个线程里由 BatchSimulator 同步推进
+// 用法: batch_runner -m <地图> [-m <地图>...] [-n 每张地图的局数] [-f 帧数] [-q 只输出汇总] [-- main的参数]
+// 结果与 headless_runner -i 逐局相同；汇总给出决策与物理各自的耗时，以及每核每秒完成的对局数
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <chrono>
+
+#include "BatchSimulator.hpp"
+#include "../Engine.hpp"
+#include "../Protocol.hpp"
+
+static bool LoadMapLines(const char* path, std::vector<std::string>& lines) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string l;
+    while (std::getline(file, l)) {
+        if (!l.empty() && l.back() == '\r') {
+            l.pop_back();
+        }
+        lines.push_back(l);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> mapPaths;
+    int copies = 1;
+    int totalFrames = global::TOTAL_FRAMES;
+    bool quiet = false;
+    bool mcts = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            mapPaths.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            copies = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            totalFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--") == 0) {
+            // main的参数，只认 -p mcts
+            for (int j = i + 1; j + 1 < argc; j++) {
+                mcts = mcts || (strcmp(argv[j], "-p") == 0 && strcmp(argv[j + 1], "mcts") == 0);
+            }
+            break;
+        }
+    }
+    if (mapPaths.empty()) {
+        fprintf(stderr, "usage: %s -m <map> [-m <map>...] [-n copies] [-f frames] [-q] [-- main args...]\n", argv[0]);
+        return 2;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto startupBegin = Clock::now();
+    BatchSimulator batch;
+    std::vector<std::unique_ptr<Engine>> engines;
+    std::vector<const char*> names;
+    for (const char* path: mapPaths) {
+        std::vector<std::string> lines;
+        if (!LoadMapLines(path, lines)) {
+            fprintf(stderr, "cannot open map %s\n", path);
+            return 2;
+        }
+        std::string text;
+        for (const auto& l: lines) {
+            text += l;
+            text += '\n';
+        }
+        Simulator sim;
+        sim.LoadMap(lines);
+        for (int c = 0; c < copies; c++) {
+            batch.Add(sim);
+            engines.push_back(std::make_unique<Engine>());
+            if (mcts) {
+                engines.back()->SetPlanner(std::make_unique<MCTSPlanner>());
+            }
+            engines.back()->LoadMap(text);
+            names.push_back(path);
+        }
+    }
+    double startupMs = std::chrono::duration<double, std::milli>(Clock::now() - startupBegin).count();
+
+    const int n = batch.MatchCount();
+    std::vector<Engine::Frame> frames(n);
+    double engineMs = 0.0, physicsMs = 0.0;
+    for (int f = 1; f <= totalFrames; f++) {
+        auto begin = Clock::now();
+        for (int m = 0; m < n; m++) {
+            const Simulator& sim = batch.GetMatch(m);
+            Engine::Frame& frame = frames[m];
+            frame.frameID = f;
+            frame.money = sim.money;
+            frame.worktops.resize(sim.worktops.size());
+            for (size_t i = 0; i < sim.worktops.size(); i++) {
+                const SimWorktop& w = sim.worktops[i];
+                frame.worktops[i] = {w.type, w.x, w.y, w.remaining, w.material, w.product ? 1 : 0};
+            }
+            frame.robots.resize(batch.RobotCount(m));
+            for (int i = 0; i < batch.RobotCount(m); i++) {
+                const SimRobot r = batch.GetRobot(m, i);
+                frame.robots[i] = {r.worktopID, r.carrying, r.TimeCoef(), r.CollisionCoef(), r.palstance, r.vx, r.vy,
+                                   r.orientation, r.x, r.y};
+            }
+            protocol::Quantize(frame);
+            for (const auto& i: engines[m]->Step(frame)) {
+                batch.Command(m, Instruction::TypeName(i.type), i.robotID, protocol::QuantizeCommand(i.value));
+            }
+            engines[m]->EndFrame();
+        }
+        auto stepped = Clock::now();
+        batch.Step();
+        engineMs += std::chrono::duration<double, std::milli>(stepped - begin).count();
+        physicsMs += std::chrono::duration<double, std::milli>(Clock::now() - stepped).count();
+    }
+
+    long long money = 0;
+    for (int m = 0; m < n; m++) {
+        const Simulator& sim = batch.GetMatch(m);
+        money += sim.money;
+        if (!quiet) {
+            printf("map=%s money=%d buys=%lld sells=%lld destroys=%lld collisions=%lld invalid=%lld\n", names[m],
+                   sim.money, sim.stats.buys, sim.stats.sells, sim.stats.destroys, sim.stats.collisions,
+                   sim.stats.invalidCommands);
+        }
+    }
+    const double totalS = (startupMs + engineMs + physicsMs) / 1000.0;
+    printf("matches=%d frames=%d total_money=%lld startup_ms=%.1f engine_ms=%.1f physics_ms=%.1f "
+           "physics_us_per_match_frame=%.3f matches_per_s=%.2f\n",
+           n, totalFrames, money, startupMs, engineMs, physicsMs,
+           n ? physicsMs * 1000.0 / ((double) n * totalFrames) : 0.0, totalS > 0.0 ? n / totalS : 0.0);
+    return 0;
+}
@@ -0,0 +1,346 @@
+//
+// 多局并行的离线判题器：机器人状态按数组结构（SoA）存放，所有对局同步推进一帧
+// header only
+//
+
+#ifndef CODECRAFTSDK_BATCHSIMULATOR_HPP
+#define CODECRAFTSDK_BATCHSIMULATOR_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Simulator.hpp"
+
+/**
+ * @brief 多局同步推进的判题器
+ *
+ * 运动模型与 Simulator::Step 一致，结果逐位相同：加速度、角加速度、质量与半径取自
+ * Robot::Acceleration()、AngularAcceleration()、Weight()、Radius()，按是否携带物品预先算好两组。
+ * 所有对局的机器人连续存放在同一组数组里，运动积分、撞墙与交易范围在一趟循环中处理全部对局；
+ * 机器人之间的碰撞只在同一局内成对处理。
+ * 工作台、金钱、交易规则与统计仍由每局的 Simulator 保存，买卖等指令借用 Simulator::Command 执行。
+ */
+class BatchSimulator {
+public:
+    /**
+     * 加入一局，返回对局序号
+     * @param sim 已读取地图的判题器，机器人状态移入批量数组，之后以批量数组为准
+     */
+    int Add(const Simulator& sim) {
+        Match m;
+        m.sim = sim;
+        m.begin = (int) x.size();
+        m.end = m.begin + (int) sim.robots.size();
+        for (const auto& r: sim.robots) {
+            x.push_back(r.x);
+            y.push_back(r.y);
+            vx.push_back(r.vx);
+            vy.push_back(r.vy);
+            orientation.push_back(r.orientation);
+            palstance.push_back(r.palstance);
+            targetSpeed.push_back(r.targetSpeed);
+            targetPalstance.push_back(r.targetPalstance);
+            collisionImpulse.push_back(r.collisionImpulse);
+            carrying.push_back(r.carrying);
+            heldFrames.push_back(r.heldFrames);
+            worktopID.push_back(r.worktopID);
+        }
+        m.sim.robots.clear();
+        m.worktopBegin = (int) worktopX.size();
+        m.worktopEnd = m.worktopBegin + (int) sim.worktops.size();
+        for (const auto& w: sim.worktops) {
+            worktopX.push_back(w.x);
+            worktopY.push_back(w.y);
+        }
+        matches.push_back(std::move(m));
+        cosHeading.resize(x.size());
+        sinHeading.resize(x.size());
+        return (int) matches.size() - 1;
+    }
+
+    int MatchCount() const {
+        return (int) matches.size();
+    }
+
+    const Simulator& GetMatch(int match) const {
+        return matches[match].sim;
+    }
+
+    /**
+     * 对局中的机器人，拷贝成 Simulator 的格式
+     */
+    SimRobot GetRobot(int match, int robot) const {
+        const int i = matches[match].begin + robot;
+        SimRobot r{};
+        r.x = x[i];
+        r.y = y[i];
+        r.vx = vx[i];
+        r.vy = vy[i];
+        r.orientation = orientation[i];
+        r.palstance = palstance[i];
+        r.targetSpeed = targetSpeed[i];
+        r.targetPalstance = targetPalstance[i];
+        r.carrying = carrying[i];
+        r.heldFrames = heldFrames[i];
+        r.collisionImpulse = collisionImpulse[i];
+        r.worktopID = worktopID[i];
+        return r;
+    }
+
+    int RobotCount(int match) const {
+        return matches[match].end - matches[match].begin;
+    }
+
+    /**
+     * 执行一条控制指令，语义同 Simulator::Command
+     */
+    void Command(int match, const char* name, int robotID, double value) {
+        Match& m = matches[match];
+        if (robotID < 0 || robotID >= m.end - m.begin) {
+            m.sim.stats.invalidCommands++;
+            return;
+        }
+        const int i = m.begin + robotID;
+        if (strcmp(name, "forward") == 0) {
+            targetSpeed[i] = std::clamp(value, -2.0, 6.0);
+        } else if (strcmp(name, "rotate") == 0) {
+            targetPalstance[i] = std::clamp(value, -M_PI, M_PI);
+        } else {
+            // 买卖与销毁很少发生，借一个机器人槽位走 Simulator 的交易规则
+            m.sim.robots.assign(1, GetRobot(match, robotID));
+            m.sim.Command(name, 0, value);
+            const SimRobot& r = m.sim.robots[0];
+            carrying[i] = r.carrying;
+            heldFrames[i] = r.heldFrames;
+            collisionImpulse[i] = r.collisionImpulse;
+            m.sim.robots.clear();
+        }
+    }
+
+    /**
+     * 所有对局推进一帧
+     */
+    void Step() {
+        const int n = (int) x.size();
+
+        // 三角函数单独一趟，后面的循环没有函数调用
+        for (int i = 0; i < n; i++) {
+            cosHeading[i] = std::cos(orientation[i]);
+            sinHeading[i] = std::sin(orientation[i]);
+        }
+
+        Integrate(n, model, x.data(), y.data(), vx.data(), vy.data(), orientation.data(), palstance.data(),
+                  heldFrames.data(), targetSpeed.data(), targetPalstance.data(), cosHeading.data(),
+                  sinHeading.data(), carrying.data());
+
+        for (auto& m: matches) {
+            ResolveCollisions(m);
+            for (int i = m.begin; i < m.end; i++) {
+                ResolveObstacles(m, i);
+            }
+            for (int i = m.begin; i < m.end; i++) {
+                worktopID[i] = NearestWorktop(m, i);
+            }
+            for (auto& w: m.sim.worktops) {
+                Simulator::Produce(w);
+            }
+            m.sim.frameID++;
+        }
+    }
+
+private:
+    struct Match {
+        Simulator sim;
+        int begin = 0;      // 机器人在批量数组中的范围[begin, end)
+        int end = 0;
+        int worktopBegin = 0;   // 工作台坐标在批量数组中的范围[worktopBegin, worktopEnd)
+        int worktopEnd = 0;
+    };
+
+    /**
+     * 空手与持有物品两种状态下的运动参数，取自 Robot 的运动模型
+     */
+    struct MotionModel {
+        double idleRadius, holdingRadius;
+        double idleWeight, holdingWeight;
+        double idleAcc, holdingAcc;
+        double idleAngularAcc, holdingAngularAcc;
+
+        MotionModel() {
+            Robot idle(Point(0.0, 0.0));
+            Robot holding(Point(0.0, 0.0));
+            holding.carryingItemType = 1;
+            idleRadius = idle.Radius();
+            holdingRadius = holding.Radius();
+            idleWeight = idle.Weight();
+            holdingWeight = holding.Weight();
+            idleAcc = idle.Acceleration();
+            holdingAcc = holding.Acceleration();
+            idleAngularAcc = idle.AngularAcceleration();
+            holdingAngularAcc = holding.AngularAcceleration();
+        }
+    };
+
+    /**
+     * 逐机器人的运动积分与撞墙，没有分支；GCC只认参数上的__restrict，
+     * 加上 -fno-math-errno -fno-trapping-math（不改变结果）后整个循环可以向量化
+     */
+    static void Integrate(int n, const MotionModel& model, double* __restrict px, double* __restrict py,
+                          double* __restrict pvx, double* __restrict pvy, double* __restrict po,
+                          double* __restrict pw, int* __restrict held, const double* __restrict speed,
+                          const double* __restrict omega, const double* __restrict c, const double* __restrict s,
+                          const int* __restrict item) {
+        const double dt = global::TIME_PER_FRAME;
+        const double mapSize = Game::mapSize;
+        const double idleDw = model.idleAngularAcc * dt, holdingDw = model.holdingAngularAcc * dt;
+        const double idleDv = model.idleAcc * dt, holdingDv = model.holdingAcc * dt;
+        const double idleRadius = model.idleRadius, holdingRadius = model.holdingRadius;
+        for (int i = 0; i < n; i++) {
+            const bool holding = item[i] != 0;
+            const double maxDw = holding ? holdingDw : idleDw;
+            const double maxDv = holding ? holdingDv : idleDv;
+            const double rad = holding ? holdingRadius : idleRadius;
+
+            const double dw = omega[i] - pw[i];
+            pw[i] += dw < -maxDw ? -maxDw : (maxDw < dw ? maxDw : dw);
+
+            double dvx = c[i] * speed[i] - pvx[i];
+            double dvy = s[i] * speed[i] - pvy[i];
+            const double dv = std::sqrt(dvx * dvx + dvy * dvy);
+            const bool limited = dv > maxDv;
+            const double scale = maxDv / dv;
+            dvx = limited ? dvx * scale : dvx;
+            dvy = limited ? dvy * scale : dvy;
+            double vxi = pvx[i] + dvx;
+            double vyi = pvy[i] + dvy;
+
+            double xi = px[i] + vxi * dt;
+            double yi = py[i] + vyi * dt;
+            double o = po[i] + pw[i] * dt;
+            o = o > M_PI ? o - 2 * M_PI : (o < -M_PI ? o + 2 * M_PI : o);
+            po[i] = o;
+
+            const double hi = mapSize - rad;
+            // 三元运算按值选择，std::min/max返回引用会妨碍向量化
+            vxi = (xi < rad && vxi < 0.0) || (xi > hi && vxi > 0.0) ? 0.0 : vxi;
+            vyi = (yi < rad && vyi < 0.0) || (yi > hi && vyi > 0.0) ? 0.0 : vyi;
+            px[i] = xi < rad ? rad : (xi > hi ? hi : xi);
+            py[i] = yi < rad ? rad : (yi > hi ? hi : yi);
+            pvx[i] = vxi;
+            pvy[i] = vyi;
+            held[i] += holding ? 1 : 0;
+        }
+    }
+
+    double Radius(int i) const {
+        return carrying[i] != 0 ? model.holdingRadius : model.idleRadius;
+    }
+
+    double Weight(int i) const {
+        return carrying[i] != 0 ? model.holdingWeight : model.idleWeight;
+    }
+
+    /**
+     * 交易范围内最近的工作台。先用平方距离排除明显在范围外的工作台（留出余量），
+     * 剩下的才按 Simulator 的方式用hypot比较，保证结果逐位相同
+     */
+    int NearestWorktop(const Match& m, int i) const {
+        constexpr double CUTOFF = (Simulator::TRADE_RADIUS + 0.01) * (Simulator::TRADE_RADIUS + 0.01);
+        int id = -1;
+        double best = Simulator::TRADE_RADIUS;
+        const double px = x[i], py = y[i];
+        for (int k = m.worktopBegin; k < m.worktopEnd; k++) {
+            const double dx = worktopX[k] - px, dy = worktopY[k] - py;
+            if (dx * dx + dy * dy > CUTOFF) {
+                continue;
+            }
+            double d = std::hypot(dx, dy);
+            if (d < best) {
+                best = d;
+                id = k - m.worktopBegin;
+            }
+        }
+        return id;
+    }
+
+    void ResolveObstacles(const Match& m, int i) {
+        const double rad = Radius(i);
+        int row0 = std::max(0, int((Game::mapSize - y[i] - rad) / 0.5));
+        int row1 = std::min(99, int((Game::mapSize - y[i] + rad) / 0.5));
+        int col0 = std::max(0, int((x[i] - rad) / 0.5));
+        int col1 = std::min(99, int((x[i] + rad) / 0.5));
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                if (!m.sim.obstacle[row * 100 + col]) {
+                    continue;
+                }
+                double minX = col * 0.5, maxX = minX + 0.5;
+                double maxY = Game::mapSize - row * 0.5, minY = maxY - 0.5;
+                double cx = std::clamp(x[i], minX, maxX), cy = std::clamp(y[i], minY, maxY);
+                double dx = x[i] - cx, dy = y[i] - cy;
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (d >= rad || d == 0.0) {
+                    continue;
+                }
+                double nx = dx / d, ny = dy / d;
+                x[i] += nx * (rad - d);
+                y[i] += ny * (rad - d);
+                double vn = vx[i] * nx + vy[i] * ny;
+                if (vn < 0.0) {
+                    vx[i] -= vn * nx;
+                    vy[i] -= vn * ny;
+                }
+            }
+        }
+    }
+
+    void ResolveCollisions(Match& m) {
+        for (int a = m.begin; a < m.end; a++) {
+            for (int b = a + 1; b < m.end; b++) {
+                double dx = x[b] - x[a], dy = y[b] - y[a];
+                double minD = Radius(a) + Radius(b);
+                // 同 NearestWorktop，明显没有接触的先排除
+                if (dx * dx + dy * dy > (minD + 0.01) * (minD + 0.01)) {
+                    continue;
+                }
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (d >= minD || d == 0.0) {
+                    continue;
+                }
+                double nx = dx / d, ny = dy / d;
+                double ma = Weight(a), mb = Weight(b);
+                double overlap = minD - d;
+                x[a] -= nx * overlap * mb / (ma + mb);
+                y[a] -= ny * overlap * mb / (ma + mb);
+                x[b] += nx * overlap * ma / (ma + mb);
+                y[b] += ny * overlap * ma / (ma + mb);
+                double rel = (vx[b] - vx[a]) * nx + (vy[b] - vy[a]) * ny;
+                if (rel < 0.0) {
+                    double impulse = -rel * ma * mb / (ma + mb);
+                    vx[a] -= impulse / ma * nx;
+                    vy[a] -= impulse / ma * ny;
+                    vx[b] += impulse / mb * nx;
+                    vy[b] += impulse / mb * ny;
+                    collisionImpulse[a] += impulse;
+                    collisionImpulse[b] += impulse;
+                    m.sim.stats.collisions++;
+                }
+            }
+        }
+    }
+
+    MotionModel model;
+    std::vector<Match> matches;
+
+    // 所有对局的机器人，下标为 对局起点 + 机器人序号
+    std::vector<double> x, y, vx, vy, orientation, palstance;
+    std::vector<double> targetSpeed, targetPalstance, collisionImpulse;
+    std::vector<int> carrying, heldFrames, worktopID;
+    std::vector<double> cosHeading, sinHeading;
+
+    // 所有对局的工作台坐标，工作台不会移动
+    std::vector<double> worktopX, worktopY;
+};
+
+#endif //CODECRAFTSDK_BATCHSIMULATOR_HPP
@@ -0,0 +1,136 @@
+//
+// 抓包回放：mmap main -c 写出的原始输入，不经过管道直接喂给决策引擎，用于在Linux下复现与剖析真实判题器上的对局
+// 用法: capture_replayer <抓包文件> [-n 重复次数] [-q 不输出结束报告] [-P 统计硬件性能计数器] [-- main的参数]
+// 回放是开环的：每帧的输入来自抓包，本次的指令不会影响后续帧
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <chrono>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Engine.hpp"
+#include "../Protocol.hpp"
+#include "../PerfCounters.hpp"
+
+struct Mapping {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool Open(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        size = (size_t) st.st_size;
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        madvise(p, size, MADV_SEQUENTIAL);
+        data = (const char*) p;
+        return true;
+    }
+
+    ~Mapping() {
+        if (data != nullptr) {
+            munmap((void*) data, size);
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    int repeat = 1;
+    bool quiet = false;
+    bool mcts = false;
+    bool perfEnabled = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "-P") == 0) {
+            perfEnabled = true;
+        } else if (strcmp(argv[i], "--") == 0) {
+            // main的参数，只认 -p mcts
+            for (int j = i + 1; j + 1 < argc; j++) {
+                mcts = mcts || (strcmp(argv[j], "-p") == 0 && strcmp(argv[j + 1], "mcts") == 0);
+            }
+            break;
+        } else if (path == nullptr) {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr) {
+        fprintf(stderr, "usage: %s <capture> [-n repeat] [-q] [-P] [-- main args...]\n", argv[0]);
+        return 2;
+    }
+
+    Mapping capture;
+    if (!capture.Open(path)) {
+        fprintf(stderr, "cannot map %s\n", path);
+        return 2;
+    }
+
+    // 所有重复累计在一起，回放没有输出阶段
+    PerfCounters perf;
+    if (perfEnabled) {
+        perf.Open();
+    }
+    for (int run = 0; run < repeat; run++) {
+        Engine engine;
+        if (mcts) {
+            engine.SetPlanner(std::make_unique<MCTSPlanner>());
+        }
+        std::string_view text(capture.data, capture.size);
+        auto begin = std::chrono::steady_clock::now();
+        if (!engine.LoadMap(protocol::SplitMap(text))) {
+            fprintf(stderr, "capture has no map\n");
+            return 1;
+        }
+        auto loaded = std::chrono::steady_clock::now();
+        double startupMs = std::chrono::duration<double, std::milli>(loaded - begin).count();
+
+        Engine::Frame frame;
+        int frames = 0, lastMoney = 0;
+        long long instructions = 0;
+        double maxMs = 0.0;
+        auto last = loaded;
+        perf.Start();
+        while (protocol::ParseFrame(text, frame, engine.RobotCount())) {
+            perf.Lap(PerfCounters::Parse);
+            instructions += (long long) engine.Step(frame).size();
+            engine.EndFrame();
+            perf.Lap(PerfCounters::Update);
+            auto now = std::chrono::steady_clock::now();
+            maxMs = std::max(maxMs, std::chrono::duration<double, std::milli>(now - last).count());
+            last = now;
+            lastMoney = frame.money;
+            frames++;
+        }
+        double totalMs = std::chrono::duration<double, std::milli>(last - loaded).count();
+        if (!quiet && run == repeat - 1) {
+            engine.Report(std::cerr);
+        }
+        printf("capture=%s run=%d frames=%d last_money=%d instructions=%lld startup_ms=%.2f avg_frame_ms=%.4f "
+               "max_frame_ms=%.3f\n", path, run, frames, lastMoney, instructions, startupMs,
+               frames ? totalMs / frames : 0.0, maxMs);
+    }
+    if (perfEnabled) {
+        std::cerr << perf;
+    }
+    return 0;
+}
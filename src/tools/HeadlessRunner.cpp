@@ -0,0 +1,361 @@
+//
+// 无界面判题程序：通过管道驱动选手程序跑完整局比赛，输出最终金钱与耗时
+// 用法: headless_runner -m <地图或.rep回放> [-f 帧数] [-q 丢弃选手stderr] [-r 每帧毫秒] -- <选手程序> [参数...]
+//      headless_runner -i -m <地图> [-m <地图>...] [-f 帧数] [-q] [-r 每帧毫秒] [-- main的参数]
+// -r 模拟实时判题：选手每超时一个帧周期，判题器就不等待地多推进一帧（跳帧）
+// -i 在进程内直接调用决策引擎，不经过管道与文本协议；多张地图各用一个引擎实例并行运行，
+//    每张地图输出一行，cpu_ms为该局线程的CPU时间（不含MCTS的工作线程）
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <ctime>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "Simulator.hpp"
+#include "../Engine.hpp"
+#include "../Protocol.hpp"
+
+struct Pipe {
+    FILE* toBot = nullptr;
+    FILE* fromBot = nullptr;
+    pid_t pid = -1;
+};
+
+static bool Spawn(char** argv, Pipe& p, bool quiet) {
+    int in[2], out[2];
+    if (pipe(in) != 0 || pipe(out) != 0) {
+        return false;
+    }
+    p.pid = fork();
+    if (p.pid < 0) {
+        return false;
+    }
+    if (p.pid == 0) {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        close(in[0]);
+        close(in[1]);
+        close(out[0]);
+        close(out[1]);
+        if (quiet) {
+            // 丢弃选手程序的stderr
+            FILE* devNull = fopen("/dev/null", "w");
+            if (devNull != nullptr) {
+                dup2(fileno(devNull), STDERR_FILENO);
+            }
+        }
+        execvp(argv[0], argv);
+        perror("execvp");
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    p.toBot = fdopen(in[1], "w");
+    p.fromBot = fdopen(out[0], "r");
+    return p.toBot != nullptr && p.fromBot != nullptr;
+}
+
+/**
+ * 读取选手程序输出直到OK
+ * @return false表示选手程序提前退出
+ */
+static bool ReadUntilOK(FILE* f, std::vector<std::string>& lines) {
+    char line[1024];
+    lines.clear();
+    while (fgets(line, sizeof line, f)) {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+            line[--n] = '\0';
+        }
+        if (strcmp(line, "OK") == 0) {
+            return true;
+        }
+        lines.emplace_back(line);
+    }
+    return false;
+}
+
+/**
+ * 读取地图，.rep 回放文件只取开头记录的地图
+ * 回放文件为4字节长度加protobuf消息，地图是开头连续的字段1（字符串，每行一条）
+ */
+static bool LoadMapLines(const char* path, std::vector<std::string>& lines) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    size_t n = strlen(path);
+    if (n > 4 && strcmp(path + n - 4, ".rep") == 0) {
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t i = 4;
+        while (i + 2 <= data.size() && data[i] == 0x0a && (unsigned char) data[i + 1] < 0x80) {
+            size_t len = (unsigned char) data[i + 1];
+            if (i + 2 + len > data.size()) {
+                break;
+            }
+            lines.push_back(data.substr(i + 2, len));
+            i += 2 + len;
+        }
+        return !lines.empty();
+    }
+    std::string l;
+    while (std::getline(file, l)) {
+        if (!l.empty() && l.back() == '\r') {
+            l.pop_back();
+        }
+        lines.push_back(l);
+    }
+    return true;
+}
+
+struct Options {
+    int totalFrames = global::TOTAL_FRAMES;
+    bool quiet = false;
+    double realtimeMs = 0.0;
+};
+
+struct Result {
+    int frames = 0;
+    int skipped = 0;
+    double startupMs = 0.0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    double cpuMs = 0.0;
+};
+
+/**
+ * 跑完整局，exchange(sim)把当前帧交给选手并执行返回的指令，返回false表示选手提前退出
+ */
+template<typename Exchange>
+static void Play(Simulator& sim, const Options& opt, Result& res, Exchange exchange) {
+    for (int f = 1; f <= opt.totalFrames; f++) {
+        sim.frameID = f;
+        auto begin = std::chrono::steady_clock::now();
+        if (!exchange(sim)) {
+            fprintf(stderr, "bot exited at frame %d\n", f);
+            break;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        res.totalMs += ms;
+        res.maxMs = std::max(res.maxMs, ms);
+        res.frames++;
+        sim.Step();
+        // 超时的帧周期里机器人按原有指令继续运动，选手收不到这些帧
+        for (int late = opt.realtimeMs > 0.0 ? (int) (ms / opt.realtimeMs) : 0; late > 0 && f < opt.totalFrames; late--) {
+            sim.frameID = ++f;
+            sim.Step();
+            res.skipped++;
+        }
+    }
+}
+
+/**
+ * 通过管道驱动选手程序
+ */
+static bool RunPiped(Simulator& sim, const std::vector<std::string>& mapLines, char** botArgv, const Options& opt,
+                     Result& res) {
+    Pipe bot;
+    if (!Spawn(botArgv, bot, opt.quiet)) {
+        fprintf(stderr, "cannot start bot\n");
+        return false;
+    }
+
+    for (const auto& m: mapLines) {
+        fprintf(bot.toBot, "%s\n", m.c_str());
+    }
+    fprintf(bot.toBot, "OK\n");
+    fflush(bot.toBot);
+
+    std::vector<std::string> reply;
+    auto startupBegin = std::chrono::steady_clock::now();
+    if (!ReadUntilOK(bot.fromBot, reply)) {
+        fprintf(stderr, "bot exited during init\n");
+        return false;
+    }
+    res.startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin)
+            .count();
+
+    Play(sim, opt, res, [&](Simulator& s) {
+        fputs(s.FrameText().c_str(), bot.toBot);
+        fflush(bot.toBot);
+        if (!ReadUntilOK(bot.fromBot, reply)) {
+            return false;
+        }
+        if (!reply.empty()) {
+            reply.erase(reply.begin());     // 帧号
+        }
+        s.ApplyCommands(reply);
+        return true;
+    });
+
+    fclose(bot.toBot);
+    int status = 0;
+    waitpid(bot.pid, &status, 0);
+    struct rusage usage{};
+    getrusage(RUSAGE_CHILDREN, &usage);
+    res.cpuMs = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+                usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    return true;
+}
+
+static double ThreadCpuMs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * 在进程内驱动决策引擎，判题器的状态直接填入引擎的输入，指令直接交给判题器执行
+ * @param botArgs main的参数，只认 -p mcts
+ */
+static bool RunInProcess(Simulator& sim, const std::vector<std::string>& mapLines,
+                         const std::vector<std::string>& botArgs, const Options& opt, Result& res) {
+    const double cpuBegin = ThreadCpuMs();
+    Engine engine;
+    for (size_t i = 0; i + 1 < botArgs.size(); i++) {
+        if (botArgs[i] == "-p" && botArgs[i + 1] == "mcts") {
+            engine.SetPlanner(std::make_unique<MCTSPlanner>());
+        }
+    }
+    std::string text;
+    for (const auto& m: mapLines) {
+        text += m;
+        text += '\n';
+    }
+    auto startupBegin = std::chrono::steady_clock::now();
+    if (!engine.LoadMap(text)) {
+        fprintf(stderr, "map has no robot\n");
+        return false;
+    }
+    res.startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin)
+            .count();
+
+    Engine::Frame frame;
+    Play(sim, opt, res, [&](Simulator& s) {
+        frame.frameID = s.frameID;
+        frame.money = s.money;
+        frame.worktops.resize(s.worktops.size());
+        for (size_t i = 0; i < s.worktops.size(); i++) {
+            const SimWorktop& w = s.worktops[i];
+            frame.worktops[i] = {w.type, w.x, w.y, w.remaining, w.material, w.product ? 1 : 0};
+        }
+        frame.robots.resize(s.robots.size());
+        for (size_t i = 0; i < s.robots.size(); i++) {
+            const SimRobot& r = s.robots[i];
+            frame.robots[i] = {r.worktopID, r.carrying, r.TimeCoef(), r.CollisionCoef(), r.palstance, r.vx, r.vy,
+                               r.orientation, r.x, r.y};
+        }
+        protocol::Quantize(frame);
+        for (const auto& i: engine.Step(frame)) {
+            s.Command(Instruction::TypeName(i.type), i.robotID, protocol::QuantizeCommand(i.value));
+        }
+        engine.EndFrame();
+        return true;
+    });
+    if (!opt.quiet) {
+        // 多局并行时整段输出，避免报告交错
+        std::ostringstream report;
+        engine.Report(report);
+        fputs(report.str().c_str(), stderr);
+    }
+    res.cpuMs = ThreadCpuMs() - cpuBegin;
+    return true;
+}
+
+static void PrintResult(const char* mapPath, const Simulator& sim, const Result& res) {
+    printf("map=%s money=%d frames=%d skipped=%d buys=%lld sells=%lld destroys=%lld collisions=%lld invalid=%lld "
+           "startup_ms=%.2f avg_frame_ms=%.4f max_frame_ms=%.3f cpu_ms=%.1f\n",
+           mapPath, sim.money, res.frames, res.skipped, sim.stats.buys, sim.stats.sells, sim.stats.destroys,
+           sim.stats.collisions, sim.stats.invalidCommands, res.startupMs,
+           res.frames ? res.totalMs / res.frames : 0.0, res.maxMs, res.cpuMs);
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> mapPaths;
+    Options opt;
+    bool inProcess = false;
+    int botArg = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            mapPaths.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            opt.totalFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            opt.quiet = true;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            opt.realtimeMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0) {
+            inProcess = true;
+        } else if (strcmp(argv[i], "--") == 0) {
+            botArg = i + 1;
+            break;
+        }
+    }
+    if (mapPaths.empty() || (!inProcess && (mapPaths.size() != 1 || botArg < 0 || botArg >= argc))) {
+        fprintf(stderr, "usage: %s -m <map> [-f frames] [-q] [-r frame_ms] -- <bot> [args...]\n"
+                        "       %s -i -m <map> [-m <map>...] [-f frames] [-q] [-r frame_ms] [-- main args...]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+
+    const int n = (int) mapPaths.size();
+    std::vector<std::vector<std::string>> mapLines(n);
+    for (int i = 0; i < n; i++) {
+        if (!LoadMapLines(mapPaths[i], mapLines[i])) {
+            fprintf(stderr, "cannot open map %s\n", mapPaths[i]);
+            return 2;
+        }
+    }
+
+    std::vector<Simulator> sims(n);
+    std::vector<Result> results(n);
+    if (!inProcess) {
+        sims[0].LoadMap(mapLines[0]);
+        if (!RunPiped(sims[0], mapLines[0], argv + botArg, opt, results[0])) {
+            return 1;
+        }
+        PrintResult(mapPaths[0], sims[0], results[0]);
+        return 0;
+    }
+
+    std::vector<std::string> botArgs;
+    for (int i = botArg; botArg > 0 && i < argc; i++) {
+        botArgs.emplace_back(argv[i]);
+    }
+    // 每个线程依次领取地图，每局一个独立的引擎实例
+    std::vector<char> ok(n, 0);
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next++; i < n; i = next++) {
+            sims[i].LoadMap(mapLines[i]);
+            ok[i] = RunInProcess(sims[i], mapLines[i], botArgs, opt, results[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = std::min(n, std::max(1, (int) std::thread::hardware_concurrency())); t > 0; t--) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    int failed = 0;
+    for (int i = 0; i < n; i++) {
+        if (ok[i]) {
+            PrintResult(mapPaths[i], sims[i], results[i]);
+        } else {
+            failed++;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
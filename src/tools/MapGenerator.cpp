@@ -0,0 +1,359 @@
+//
+// 合成地图生成器：按给定的随机种子生成100×100的地图文本（与 LoadMap() 读取的格式相同），用于压力测试与调参语料
+// 用法: map_generator [-s 种子] [-w 工作台数] [-r 机器人数] [-c 类型:数量,...] [-k 簇数] [-K 簇半径]
+//                     [-d 原料到收购点的格数] [-b 障碍密度] [-p uniform|center|corner] [-o 输出文件]
+//
+// -c 指定某些类型的数量，其余工作台（直到 -w）按比赛地图的比例随机抽取
+// -k 大于0时工作台围绕k个随机中心按正态分布摆放，-K 为标准差（格）
+// -d 大于0时8、9号工作台尽量放在离最近的原料工作台（1~3号）约d格的位置
+// -b 为障碍格占全图的比例，障碍是互不相接、也不接触边界的直墙，因此所有空地连通
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+static constexpr int SIZE = 100;
+static constexpr int BORDER = 2;
+// 墙与墙、墙与边界之间至少空出的格数，保证机器人能从任何缝隙通过；工作台与机器人只要求不贴墙
+static constexpr int WALL_MARGIN = 3;
+static constexpr int WALL_MIN_LENGTH = 4;
+static constexpr int WALL_MAX_LENGTH = 24;
+// 选收购点位置时的候选数
+static constexpr int SINK_CANDIDATES = 32;
+
+// 各类型工作台的相对数量，与比赛地图的组成大致相同：原料多，高级产品与收购点少
+static constexpr int TYPE_WEIGHTS[10] = {0, 14, 14, 14, 10, 10, 10, 6, 3, 4};
+
+struct Options {
+    unsigned seed = 1;
+    int worktops = 50;
+    int robots = 4;
+    int counts[10] = {};        // 指定的各类型数量，-1为未指定
+    int clusters = 0;
+    double spread = 6.0;
+    double sinkDistance = 0.0;
+    double obstacleDensity = 0.0;
+    std::string robotPlacement = "uniform";
+    const char* outPath = nullptr;
+};
+
+class Generator {
+public:
+    explicit Generator(const Options& o) : opt(o), rng(o.seed), map(SIZE, std::string(SIZE, '.')) {}
+
+    /**
+     * @return false表示空地不够，放不下所有工作台或机器人
+     */
+    bool Run() {
+        PlaceWalls();
+        std::vector<int> types = WorktopTypes();
+        // 先放原料，收购点才能参照原料的位置
+        std::stable_sort(types.begin(), types.end());
+        for (int i = 0; i < opt.clusters; i++) {
+            centers.push_back({Uniform(), Uniform()});
+        }
+        for (int t: types) {
+            bool ok = (t == 8 || t == 9) && opt.sinkDistance > 0.0 ? PlaceSink((char) ('0' + t))
+                                                                   : PlaceWorktop((char) ('0' + t));
+            if (!ok) {
+                return false;
+            }
+        }
+        for (int i = 0; i < opt.robots; i++) {
+            if (!PlaceRobot()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::vector<std::string>& Map() const {
+        return map;
+    }
+
+private:
+    struct Cell {
+        int row, col;
+    };
+
+    int Uniform() {
+        return std::uniform_int_distribution<int>(BORDER, SIZE - 1 - BORDER)(rng);
+    }
+
+    static bool Inside(int row, int col) {
+        return row >= BORDER && row < SIZE - BORDER && col >= BORDER && col < SIZE - BORDER;
+    }
+
+    /**
+     * 空地且周围一格内没有障碍，避免工作台与机器人贴墙
+     */
+    bool Free(int row, int col) const {
+        if (!Inside(row, col) || map[row][col] != '.') {
+            return false;
+        }
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                if (map[row + dr][col + dc] == '#') {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * 在中心附近按正态分布找一个空位，多次失败后退化为均匀分布
+     */
+    bool PlaceNear(char c, double row, double col, double sigma) {
+        std::normal_distribution<double> offset(0.0, sigma);
+        for (int attempt = 0; attempt < 200; attempt++) {
+            int r = (int) std::lround(row + offset(rng)), cc = (int) std::lround(col + offset(rng));
+            if (Free(r, cc)) {
+                map[r][cc] = c;
+                return true;
+            }
+        }
+        return PlaceUniform(c);
+    }
+
+    bool PlaceUniform(char c) {
+        for (int attempt = 0; attempt < SIZE * SIZE * 4; attempt++) {
+            int r = Uniform(), cc = Uniform();
+            if (Free(r, cc)) {
+                map[r][cc] = c;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool PlaceWorktop(char c) {
+        if (centers.empty()) {
+            return PlaceUniform(c);
+        }
+        const Cell& center = centers[std::uniform_int_distribution<int>(0, (int) centers.size() - 1)(rng)];
+        return PlaceNear(c, center.row, center.col, opt.spread);
+    }
+
+    /**
+     * 在若干候选位置中选离最近原料工作台的距离最接近sinkDistance的一个
+     */
+    bool PlaceSink(char c) {
+        std::vector<Cell> raw;
+        for (int r = 0; r < SIZE; r++) {
+            for (int cc = 0; cc < SIZE; cc++) {
+                if (map[r][cc] >= '1' && map[r][cc] <= '3') {
+                    raw.push_back({r, cc});
+                }
+            }
+        }
+        if (raw.empty()) {
+            return PlaceWorktop(c);
+        }
+        Cell best{-1, -1};
+        double bestError = 1e18;
+        for (int i = 0; i < SINK_CANDIDATES; i++) {
+            int r = Uniform(), cc = Uniform();
+            if (!Free(r, cc)) {
+                continue;
+            }
+            double nearest = 1e18;
+            for (const Cell& p: raw) {
+                nearest = std::min(nearest, std::hypot(p.row - r, p.col - cc));
+            }
+            double error = std::abs(nearest - opt.sinkDistance);
+            if (error < bestError) {
+                bestError = error;
+                best = {r, cc};
+            }
+        }
+        if (best.row < 0) {
+            return PlaceUniform(c);
+        }
+        map[best.row][best.col] = c;
+        return true;
+    }
+
+    bool PlaceRobot() {
+        if (opt.robotPlacement == "center") {
+            return PlaceNear('A', SIZE / 2.0, SIZE / 2.0, 4.0);
+        }
+        if (opt.robotPlacement == "corner") {
+            return PlaceNear('A', BORDER + 4.0, BORDER + 4.0, 3.0);
+        }
+        return PlaceUniform('A');
+    }
+
+    /**
+     * 各工作台的类型：先放指定数量的类型，剩余的按权重抽取；工作台足够多时每种类型至少一个
+     */
+    std::vector<int> WorktopTypes() {
+        std::vector<int> types;
+        int weights[10];
+        bool anySpecified = false;
+        for (int t = 1; t <= 9; t++) {
+            if (opt.counts[t] >= 0) {
+                types.insert(types.end(), opt.counts[t], t);
+                anySpecified = true;
+            }
+            weights[t] = opt.counts[t] >= 0 ? 0 : TYPE_WEIGHTS[t];
+        }
+        weights[0] = 0;
+        if (!anySpecified && opt.worktops >= 9) {
+            for (int t = 1; t <= 9; t++) {
+                types.push_back(t);
+            }
+        }
+        if (std::count_if(weights + 1, weights + 10, [](int w) { return w > 0; }) > 0) {
+            std::discrete_distribution<int> type(std::begin(weights), std::end(weights));
+            while ((int) types.size() < opt.worktops) {
+                types.push_back(type(rng));
+            }
+        }
+        return types;
+    }
+
+    /**
+     * 放置直墙直到障碍格达到目标比例，新墙与已有的墙以及边界至少相隔WALL_MARGIN格
+     */
+    void PlaceWalls() {
+        const int target = (int) (opt.obstacleDensity * SIZE * SIZE);
+        std::uniform_int_distribution<int> length(WALL_MIN_LENGTH, WALL_MAX_LENGTH);
+        std::uniform_int_distribution<int> thickness(1, 2);
+        std::uniform_int_distribution<int> pos(WALL_MARGIN, SIZE - 1 - WALL_MARGIN);
+        int placed = 0;
+        for (int attempt = 0; placed < target && attempt < target * 50; attempt++) {
+            bool horizontal = std::bernoulli_distribution(0.5)(rng);
+            int len = length(rng), thick = thickness(rng);
+            int rows = horizontal ? thick : len, cols = horizontal ? len : thick;
+            int r0 = pos(rng), c0 = pos(rng);
+            if (r0 + rows > SIZE - WALL_MARGIN || c0 + cols > SIZE - WALL_MARGIN || !Clear(r0, c0, rows, cols)) {
+                continue;
+            }
+            for (int r = r0; r < r0 + rows; r++) {
+                for (int c = c0; c < c0 + cols; c++) {
+                    map[r][c] = '#';
+                }
+            }
+            placed += rows * cols;
+        }
+    }
+
+    /**
+     * 矩形向外扩WALL_MARGIN格的范围内是否没有障碍
+     */
+    bool Clear(int r0, int c0, int rows, int cols) const {
+        for (int r = r0 - WALL_MARGIN; r < r0 + rows + WALL_MARGIN; r++) {
+            for (int c = c0 - WALL_MARGIN; c < c0 + cols + WALL_MARGIN; c++) {
+                if (r >= 0 && r < SIZE && c >= 0 && c < SIZE && map[r][c] == '#') {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    const Options& opt;
+    std::mt19937 rng;
+    std::vector<std::string> map;
+    std::vector<Cell> centers;
+};
+
+/**
+ * 解析 "1:6,2:6,9:1" 形式的类型数量
+ */
+static bool ParseCounts(const char* text, int counts[10]) {
+    std::string s(text);
+    size_t begin = 0;
+    while (begin < s.size()) {
+        size_t end = s.find(',', begin);
+        std::string item = s.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        int type, count;
+        if (sscanf(item.c_str(), "%d:%d", &type, &count) != 2 || type < 1 || type > 9 || count < 0) {
+            return false;
+        }
+        counts[type] = count;
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+static int Usage(const char* name) {
+    fprintf(stderr, "usage: %s [-s seed] [-w worktops] [-r robots] [-c type:count,...] [-k clusters] [-K spread]\n"
+                    "          [-d sink_distance] [-b obstacle_density] [-p uniform|center|corner] [-o out]\n", name);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::fill(std::begin(opt.counts), std::end(opt.counts), -1);
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* v = argv[i + 1];
+        if (strcmp(argv[i], "-s") == 0) {
+            opt.seed = (unsigned) strtoul(v, nullptr, 10);
+        } else if (strcmp(argv[i], "-w") == 0) {
+            opt.worktops = atoi(v);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            opt.robots = atoi(v);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            if (!ParseCounts(v, opt.counts)) {
+                return Usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "-k") == 0) {
+            opt.clusters = atoi(v);
+        } else if (strcmp(argv[i], "-K") == 0) {
+            opt.spread = atof(v);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            opt.sinkDistance = atof(v);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            opt.obstacleDensity = std::clamp(atof(v), 0.0, 0.3);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            opt.robotPlacement = v;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            opt.outPath = v;
+        } else {
+            return Usage(argv[0]);
+        }
+    }
+    if (argc % 2 == 0) {
+        return Usage(argv[0]);
+    }
+    int specified = 0;
+    for (int t = 1; t <= 9; t++) {
+        specified += std::max(opt.counts[t], 0);
+    }
+    opt.worktops = std::max(opt.worktops, specified);
+    const int inner = SIZE - 2 * BORDER;
+    if (opt.robots < 1 || opt.worktops + opt.robots > inner * inner / 4) {
+        fprintf(stderr, "too many worktops or robots for a %dx%d map\n", SIZE, SIZE);
+        return 2;
+    }
+
+    Generator generator(opt);
+    if (!generator.Run()) {
+        fprintf(stderr, "not enough free cells, lower the obstacle density\n");
+        return 1;
+    }
+
+    FILE* out = opt.outPath == nullptr ? stdout : fopen(opt.outPath, "w");
+    if (out == nullptr) {
+        fprintf(stderr, "cannot open %s\n", opt.outPath);
+        return 2;
+    }
+    for (const auto& line: generator.Map()) {
+        fprintf(out, "%s\n", line.c_str());
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
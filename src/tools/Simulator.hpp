@@ -0,0 +1,406 @@
+//
+// 离线判题器模型，按照任务书规则推进一局比赛（无图形界面）
+// header only
+//
+
+#ifndef CODECRAFTSDK_SIMULATOR_HPP
+#define CODECRAFTSDK_SIMULATOR_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+
+#include "../Structure.hpp"
+#include "../GlobalSetting.h"
+
+/**
+ * 价值系数函数 f(x, maxX, minRate)
+ */
+inline double ValueRate(double x, double maxX, double minRate) {
+    if (x >= maxX) {
+        return minRate;
+    }
+    double t = 1.0 - x / maxX;
+    return (1.0 - std::sqrt(1.0 - t * t)) * (1.0 - minRate) + minRate;
+}
+
+struct SimRobot {
+    double x, y;
+    double vx = 0.0, vy = 0.0;
+    double orientation = 0.0;
+    double palstance = 0.0;
+    double targetSpeed = 0.0;
+    double targetPalstance = 0.0;
+    int carrying = 0;
+    int heldFrames = 0;             // 持有物品的帧数
+    double collisionImpulse = 0.0;  // 持有物品期间累计的碰撞冲量
+    int worktopID = -1;
+
+    double Radius() const {
+        return carrying == 0 ? Robot::radiusIdle : Robot::radiusHolding;
+    }
+
+    double Weight() const {
+        return M_PI * Radius() * Radius() * Robot::assumedDensity;
+    }
+
+    double TimeCoef() const {
+        return carrying == 0 ? 0.0 : ValueRate(heldFrames, 9000, 0.8);
+    }
+
+    double CollisionCoef() const {
+        return carrying == 0 ? 0.0 : ValueRate(collisionImpulse, 1000, 0.8);
+    }
+};
+
+struct SimWorktop {
+    double x, y;
+    int type;
+    int remaining = -1;
+    int material = 0;
+    bool product = false;
+    int purchasingBits = 0;
+    int workCycle = 0;
+};
+
+/**
+ * 比赛统计
+ */
+struct SimStats {
+    long long buys = 0;
+    long long sells = 0;
+    long long destroys = 0;
+    long long collisions = 0;
+    long long invalidCommands = 0;
+};
+
+class Simulator {
+public:
+    static constexpr double TRADE_RADIUS = 0.4;
+    static constexpr int INITIAL_MONEY = 200000;
+
+    int frameID = 0;
+    int money = INITIAL_MONEY;
+    std::vector<SimRobot> robots;
+    std::vector<SimWorktop> worktops;
+    std::vector<uint8_t> obstacle = std::vector<uint8_t>(100 * 100, 0);
+    SimStats stats;
+
+    /**
+     * 按地图文本初始化
+     * @param lines 地图的每一行
+     */
+    void LoadMap(const std::vector<std::string>& lines) {
+        robots.clear();
+        worktops.clear();
+        for (int row = 0; row < (int) lines.size(); row++) {
+            const std::string& line = lines[row];
+            for (int col = 0; col < (int) line.size(); col++) {
+                double x = 0.25 + 0.5 * col;
+                double y = 49.75 - 0.5 * row;
+                char c = line[col];
+                if (c == '#' && row < 100 && col < 100) {
+                    obstacle[row * 100 + col] = 1;
+                } else if (c == 'A') {
+                    SimRobot r{};
+                    r.x = x;
+                    r.y = y;
+                    r.worktopID = -1;
+                    robots.push_back(r);
+                } else if (c >= '1' && c <= '9') {
+                    SimWorktop w{};
+                    w.x = x;
+                    w.y = y;
+                    w.type = c - '0';
+                    const WorktopType& config = worktopTypeDict.find(w.type)->second;
+                    for (auto i: config.purchasingItemTypes) {
+                        w.purchasingBits |= (1 << i);
+                    }
+                    w.workCycle = config.workCycle;
+                    w.remaining = w.purchasingBits == 0 ? w.workCycle : -1;
+                    worktops.push_back(w);
+                }
+            }
+        }
+    }
+
+    /**
+     * 生成当前帧发给选手程序的文本
+     */
+    std::string FrameText() const {
+        std::string res;
+        char buf[256];
+        snprintf(buf, sizeof buf, "%d %d\n%d\n", frameID, money, (int) worktops.size());
+        res += buf;
+        for (const auto& w: worktops) {
+            snprintf(buf, sizeof buf, "%d %.2f %.2f %d %d %d\n", w.type, w.x, w.y, w.remaining, w.material,
+                     w.product ? 1 : 0);
+            res += buf;
+        }
+        for (const auto& r: robots) {
+            snprintf(buf, sizeof buf, "%d %d %.7f %.7f %.7f %.7f %.7f %.7f %.7f %.7f\n", r.worktopID, r.carrying,
+                     r.TimeCoef(), r.CollisionCoef(), r.palstance, r.vx, r.vy, r.orientation, r.x, r.y);
+            res += buf;
+        }
+        res += "OK\n";
+        return res;
+    }
+
+    /**
+     * 执行一条控制指令
+     */
+    void Command(const char* name, int robotID, double value) {
+        if (robotID < 0 || robotID >= (int) robots.size()) {
+            stats.invalidCommands++;
+            return;
+        }
+        SimRobot& r = robots[robotID];
+        if (strcmp(name, "forward") == 0) {
+            r.targetSpeed = std::clamp(value, -2.0, 6.0);
+        } else if (strcmp(name, "rotate") == 0) {
+            r.targetPalstance = std::clamp(value, -M_PI, M_PI);
+        } else if (strcmp(name, "buy") == 0) {
+            Buy(r);
+        } else if (strcmp(name, "sell") == 0) {
+            Sell(r);
+        } else if (strcmp(name, "destroy") == 0) {
+            if (r.carrying != 0) {
+                r.carrying = 0;
+                stats.destroys++;
+            }
+        } else {
+            stats.invalidCommands++;
+        }
+    }
+
+    /**
+     * 解析选手程序一帧的输出（不含帧号行与OK行）
+     */
+    void ApplyCommands(const std::vector<std::string>& lines) {
+        char name[32];
+        int robotID;
+        double value;
+        for (const auto& l: lines) {
+            value = 0.0;
+            int n = sscanf(l.c_str(), "%31s %d %lf", name, &robotID, &value);
+            if (n >= 2) {
+                Command(name, robotID, value);
+            }
+        }
+    }
+
+    /**
+     * 推进一帧：运动、碰撞、生产
+     */
+    void Step() {
+        const double dt = global::TIME_PER_FRAME;
+        for (auto& r: robots) {
+            double m = r.Weight();
+            double acc = Robot::assumedMaxTractiveForce / m;
+            double J = 0.5 * m * r.Radius() * r.Radius();
+            double angularAcc = Robot::assumedMaxMoment / J;
+
+            double dw = r.targetPalstance - r.palstance;
+            r.palstance += std::clamp(dw, -angularAcc * dt, angularAcc * dt);
+
+            double hx = std::cos(r.orientation), hy = std::sin(r.orientation);
+            double dvx = hx * r.targetSpeed - r.vx;
+            double dvy = hy * r.targetSpeed - r.vy;
+            double dv = std::sqrt(dvx * dvx + dvy * dvy);
+            double maxDv = acc * dt;
+            if (dv > maxDv) {
+                dvx *= maxDv / dv;
+                dvy *= maxDv / dv;
+            }
+            r.vx += dvx;
+            r.vy += dvy;
+
+            r.x += r.vx * dt;
+            r.y += r.vy * dt;
+            r.orientation += r.palstance * dt;
+            if (r.orientation > M_PI) {
+                r.orientation -= 2 * M_PI;
+            } else if (r.orientation < -M_PI) {
+                r.orientation += 2 * M_PI;
+            }
+
+            double rad = r.Radius();
+            if (r.x < rad) {
+                r.x = rad;
+                r.vx = std::max(r.vx, 0.0);
+            } else if (r.x > Game::mapSize - rad) {
+                r.x = Game::mapSize - rad;
+                r.vx = std::min(r.vx, 0.0);
+            }
+            if (r.y < rad) {
+                r.y = rad;
+                r.vy = std::max(r.vy, 0.0);
+            } else if (r.y > Game::mapSize - rad) {
+                r.y = Game::mapSize - rad;
+                r.vy = std::min(r.vy, 0.0);
+            }
+            if (r.carrying != 0) {
+                r.heldFrames++;
+            }
+        }
+
+        ResolveCollisions();
+        for (auto& r: robots) {
+            ResolveObstacles(r);
+        }
+
+        for (auto& r: robots) {
+            r.worktopID = -1;
+            double best = TRADE_RADIUS;
+            for (int i = 0; i < (int) worktops.size(); i++) {
+                double d = std::hypot(worktops[i].x - r.x, worktops[i].y - r.y);
+                if (d < best) {
+                    best = d;
+                    r.worktopID = i;
+                }
+            }
+        }
+
+        for (auto& w: worktops) {
+            Produce(w);
+        }
+        frameID++;
+    }
+
+    /**
+     * 工作台推进一帧的生产
+     */
+    static void Produce(SimWorktop& w) {
+        // 8、9号工作台收到原料即刻消耗
+        if (w.workCycle == 1) {
+            w.material = 0;
+            return;
+        }
+        if (w.remaining > 0) {
+            w.remaining--;
+        }
+        if (w.remaining == 0) {
+            if (!w.product) {
+                w.product = true;
+                w.remaining = -1;
+            }
+        }
+        if (w.remaining == -1 && w.material == w.purchasingBits) {
+            w.remaining = w.workCycle;
+            w.material = 0;
+        }
+    }
+
+private:
+    void Buy(SimRobot& r) {
+        if (r.worktopID == -1 || r.carrying != 0) {
+            stats.invalidCommands++;
+            return;
+        }
+        SimWorktop& w = worktops[r.worktopID];
+        const int item = worktopTypeDict.find(w.type)->second.producingItem;
+        auto it = itemTypeDict.find(item);
+        if (!w.product || it == itemTypeDict.end() || money < it->second.purchasePrice) {
+            stats.invalidCommands++;
+            return;
+        }
+        money -= (int) it->second.purchasePrice;
+        w.product = false;
+        r.carrying = item;
+        r.heldFrames = 0;
+        r.collisionImpulse = 0.0;
+        stats.buys++;
+    }
+
+    void Sell(SimRobot& r) {
+        if (r.worktopID == -1 || r.carrying == 0) {
+            stats.invalidCommands++;
+            return;
+        }
+        SimWorktop& w = worktops[r.worktopID];
+        int bit = 1 << r.carrying;
+        if ((w.purchasingBits & bit) == 0 || (w.material & bit) != 0) {
+            stats.invalidCommands++;
+            return;
+        }
+        double price = itemTypeDict.find(r.carrying)->second.originalSellingPrice;
+        money += (int) (price * r.TimeCoef() * r.CollisionCoef());
+        w.material |= bit;
+        r.carrying = 0;
+        stats.sells++;
+    }
+
+    /**
+     * 机器人与障碍格（0.5m见方）的碰撞，直接推出并去掉法向速度
+     */
+    void ResolveObstacles(SimRobot& r) {
+        const double rad = r.Radius();
+        int row0 = std::max(0, int((Game::mapSize - r.y - rad) / 0.5));
+        int row1 = std::min(99, int((Game::mapSize - r.y + rad) / 0.5));
+        int col0 = std::max(0, int((r.x - rad) / 0.5));
+        int col1 = std::min(99, int((r.x + rad) / 0.5));
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                if (!obstacle[row * 100 + col]) {
+                    continue;
+                }
+                double minX = col * 0.5, maxX = minX + 0.5;
+                double maxY = Game::mapSize - row * 0.5, minY = maxY - 0.5;
+                double cx = std::clamp(r.x, minX, maxX), cy = std::clamp(r.y, minY, maxY);
+                double dx = r.x - cx, dy = r.y - cy;
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (d >= rad || d == 0.0) {
+                    continue;
+                }
+                double nx = dx / d, ny = dy / d;
+                r.x += nx * (rad - d);
+                r.y += ny * (rad - d);
+                double vn = r.vx * nx + r.vy * ny;
+                if (vn < 0.0) {
+                    r.vx -= vn * nx;
+                    r.vy -= vn * ny;
+                }
+            }
+        }
+    }
+
+    void ResolveCollisions() {
+        for (size_t i = 0; i < robots.size(); i++) {
+            for (size_t j = i + 1; j < robots.size(); j++) {
+                SimRobot& a = robots[i];
+                SimRobot& b = robots[j];
+                double dx = b.x - a.x, dy = b.y - a.y;
+                double d = std::sqrt(dx * dx + dy * dy);
+                double minD = a.Radius() + b.Radius();
+                if (d >= minD || d == 0.0) {
+                    continue;
+                }
+                double nx = dx / d, ny = dy / d;
+                double ma = a.Weight(), mb = b.Weight();
+                double overlap = minD - d;
+                a.x -= nx * overlap * mb / (ma + mb);
+                a.y -= ny * overlap * mb / (ma + mb);
+                b.x += nx * overlap * ma / (ma + mb);
+                b.y += ny * overlap * ma / (ma + mb);
+                double rel = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+                if (rel < 0.0) {
+                    double impulse = -rel * ma * mb / (ma + mb);
+                    a.vx -= impulse / ma * nx;
+                    a.vy -= impulse / ma * ny;
+                    b.vx += impulse / mb * nx;
+                    b.vy += impulse / mb * ny;
+                    a.collisionImpulse += impulse;
+                    b.collisionImpulse += impulse;
+                    stats.collisions++;
+                }
+            }
+        }
+    }
+};
+
+#endif //CODECRAFTSDK_SIMULATOR_HPP
@@ -0,0 +1,142 @@
+//
+// 遥测解码：把 main 结束时写出的二进制遥测渲染成文本，用于赛后复盘
+// 用法: telemetry_decoder <遥测文件> [-r 机器人] [-k frame|robot|task|transition] [-b 起始帧] [-e 结束帧] [-s 只输出汇总]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <map>
+
+#include "../RobotControl.hpp"
+#include "../Telemetry.hpp"
+
+// 与 main.cpp 中的全局对象对应，解码时不使用
+Game game;
+
+static const char* KindName(telemetry::Kind kind) {
+    switch (kind) {
+        case telemetry::Kind::Frame:
+            return "frame";
+        case telemetry::Kind::Robot:
+            return "robot";
+        case telemetry::Kind::Task:
+            return "task";
+        case telemetry::Kind::Transition:
+            return "transition";
+        default:
+            return "unknown";
+    }
+}
+
+static const char* StateName(int state) {
+    return state >= 0 && state < STATE_COUNT ? ToString((StateID) state) : "?";
+}
+
+static void Print(const telemetry::Record& r) {
+    printf("%6d %-10s ", r.frame, KindName(r.kind));
+    switch (r.kind) {
+        case telemetry::Kind::Frame:
+            printf("money=%d lastFrameMs=%.3f missed=%d%s\n", r.x, r.y, r.b, r.a ? " degraded" : "");
+            break;
+        case telemetry::Kind::Robot: {
+            double x, y;
+            telemetry::UnpackPosition(r.x, x, y);
+            printf("robot=%d state=%s carrying=%d pos=(%.2f,%.2f) orientation=%.3f\n", r.robot, StateName(r.b),
+                   r.a, x, y, r.y);
+            break;
+        }
+        case telemetry::Kind::Task: {
+            static const char* sources[] = {"greedy", "chain", "mcts"};
+            int worktop, sink;
+            telemetry::UnpackTask(r.x, worktop, sink);
+            printf("robot=%d worktop=%d sink=%d source=%s score=%.1f\n", r.robot, worktop, sink,
+                   r.a < 3 ? sources[r.a] : "?", r.y);
+            break;
+        }
+        case telemetry::Kind::Transition:
+            printf("robot=%d %s -> %s on %s\n", r.robot, StateName(r.a), StateName(r.b),
+                   r.x >= 0 && r.x < EVENT_COUNT ? EventName(r.x) : "?");
+            break;
+        default:
+            printf("\n");
+            break;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <telemetry.bin> [-r robot] [-k kind] [-b frame] [-e frame] [-s]\n", argv[0]);
+        return 2;
+    }
+    int robot = -1, begin = 0, end = INT32_MAX;
+    const char* kind = nullptr;
+    bool summaryOnly = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            robot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            kind = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            begin = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            end = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            summaryOnly = true;
+        }
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 2;
+    }
+    telemetry::Header h{};
+    if (fread(&h, sizeof h, 1, f) != 1 || memcmp(h.magic, telemetry::MAGIC, 4) != 0 ||
+        h.version != telemetry::VERSION || h.recordSize != sizeof(telemetry::Record)) {
+        fprintf(stderr, "%s is not a telemetry file of version %u\n", argv[1], telemetry::VERSION);
+        fclose(f);
+        return 2;
+    }
+    std::vector<telemetry::Record> records(h.count);
+    size_t n = fread(records.data(), sizeof(telemetry::Record), h.count, f);
+    fclose(f);
+    records.resize(n);
+
+    std::map<int, int> kindCount;
+    std::map<int, int> taskCount;
+    int firstFrame = -1, lastFrame = -1, degradedFrames = 0, missedFrames = 0;
+    double maxFrameMs = 0.0;
+    for (const auto& r: records) {
+        kindCount[(int) r.kind]++;
+        if (r.kind == telemetry::Kind::Frame) {
+            if (firstFrame < 0) {
+                firstFrame = r.frame;
+            }
+            lastFrame = r.frame;
+            degradedFrames += r.a;
+            missedFrames += r.b;
+            maxFrameMs = std::max(maxFrameMs, (double) r.y);
+        } else if (r.kind == telemetry::Kind::Task) {
+            taskCount[r.robot]++;
+        }
+        if (summaryOnly || r.frame < begin || r.frame > end ||
+            (kind != nullptr && strcmp(kind, KindName(r.kind)) != 0) ||
+            (robot >= 0 && r.kind != telemetry::Kind::Frame && r.robot != robot)) {
+            continue;
+        }
+        Print(r);
+    }
+
+    printf("# records: %zu of %llu written%s, frames %d..%d\n", records.size(), (unsigned long long) h.total,
+           h.total > records.size() ? " (oldest overwritten)" : "", firstFrame, lastFrame);
+    for (const auto& k: kindCount) {
+        printf("# %s: %d\n", KindName((telemetry::Kind) k.first), k.second);
+    }
+    printf("# degradedFrames: %d missedFrames: %d maxFrameMs: %.3f\n", degradedFrames, missedFrames, maxFrameMs);
+    for (const auto& t: taskCount) {
+        printf("# robot %d tasks: %d\n", t.first, t.second);
+    }
+    return 0;
+}
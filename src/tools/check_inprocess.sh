@@ -0,0 +1,37 @@
+#!/bin/bash
+# 检查进程内运行（headless_runner -i 与 batch_runner）与通过管道运行main的最终金钱是否逐图相同
+# 用法: tools/check_inprocess.sh [bin目录]
+# 不同时退出码为1
+
+SCRIPT=$(readlink -f "$0")
+BASEDIR=$(dirname "$SCRIPT")
+ROOT=$(readlink -f "$BASEDIR/../..")
+BIN=${1:-$ROOT}
+
+money() {
+    sed -n 's/.*money=\([0-9-]*\).*/\1/p'
+}
+
+status=0
+maps=()
+piped_total=0
+for map in "$ROOT"/maps/*.txt; do
+    maps+=(-m "$map")
+    piped=$("$BIN/headless_runner" -m "$map" -q -- "$BIN/main" < /dev/null | money)
+    inprocess=$("$BIN/headless_runner" -i -m "$map" -q < /dev/null | money)
+    piped_total=$((piped_total + piped))
+    if [ "$piped" == "$inprocess" ]; then
+        printf "%-24s %10s ok\n" "$(basename "$map")" "$piped"
+    else
+        printf "%-24s piped %s in-process %s MISMATCH\n" "$(basename "$map")" "$piped" "$inprocess"
+        status=1
+    fi
+done
+batch=$("$BIN/batch_runner" -q "${maps[@]}" < /dev/null | sed -n 's/.*total_money=\([0-9-]*\).*/\1/p')
+if [ "$batch" == "$piped_total" ]; then
+    printf "%-24s %10s ok\n" "batch_runner" "$batch"
+else
+    printf "%-24s piped %s batch %s MISMATCH\n" "batch_runner" "$piped_total" "$batch"
+    status=1
+fi
+exit $status
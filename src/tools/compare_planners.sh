@@ -0,0 +1,15 @@
+#!/bin/bash
+# 在所有地图上分别用贪心与MCTS规划器跑一局，输出最终金钱与CPU耗时
+# 用法: tools/compare_planners.sh [bin目录]
+
+SCRIPT=$(readlink -f "$0")
+BASEDIR=$(dirname "$SCRIPT")
+ROOT=$(readlink -f "$BASEDIR/../..")
+BIN=${1:-$ROOT}
+
+for map in "$ROOT"/maps/*.txt; do
+    for planner in greedy mcts; do
+        printf "%-8s " "$planner"
+        "$BIN/headless_runner" -m "$map" -q -- "$BIN/main" -p "$planner"
+    done
+done
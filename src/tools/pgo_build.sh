@@ -0,0 +1,64 @@
+#!/bin/bash
+# 两阶段PGO发布构建：插桩构建 -> 在训练地图上跑无界面比赛 -> 用计数重新构建，并比较前后的每帧耗时
+# 训练集为 maps/*.txt 以及 replay/*.rep 中记录的地图，贪心与MCTS规划器各跑一局
+# 用法: tools/pgo_build.sh [-march值，如native]
+# 结果main生成在仓库根目录，与普通cmake构建相同
+
+set -e
+
+SCRIPT=$(readlink -f "$0")
+BASEDIR=$(dirname "$SCRIPT")
+SRC=$(readlink -f "$BASEDIR/..")
+ROOT=$(readlink -f "$SRC/..")
+BUILD="$SRC/_pgo_build"
+PROFILE="$BUILD/pgo-profile"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+MARCH=${1:-}
+JOBS=$(nproc 2>/dev/null || echo 4)
+WORKLOAD=("$ROOT"/maps/*.txt "$ROOT"/replay/*.rep)
+
+# 参数: PGO阶段 是否LTO -march值
+configure() {
+    cmake -S "$SRC" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release -DPGO_MODE="$1" -DENABLE_LTO="$2" -DMARCH="$3" \
+        -DPGO_PROFILE_DIR="$PROFILE" > /dev/null
+    cmake --build "$BUILD" -j"$JOBS" --clean-first --target main headless_runner > /dev/null
+}
+
+# 在训练集上跑一遍，输出每局的结果行
+run_workload() {
+    local bin=$1
+    for map in "${WORKLOAD[@]}"; do
+        for planner in greedy mcts; do
+            printf "%-6s " "$planner"
+            (cd "$WORK" && "$ROOT/headless_runner" -m "$map" -q -- "$bin" -p "$planner" -t /dev/null)
+        done
+    done
+}
+
+# 按规划器汇总结果行中的平均每帧耗时与CPU时间（MCTS按时间预算搜索，主要看贪心）
+summarize() {
+    awk -v tag="$2" '{ for (i = 2; i <= NF; i++) { split($i, kv, "="); v[kv[1]] = kv[2] }
+           frame[$1] += v["avg_frame_ms"]; cpu[$1] += v["cpu_ms"]; money[$1] += v["money"]; n[$1]++ }
+         END { for (p in n) printf "%-7s %-6s matches=%d avg_frame_ms=%.4f cpu_ms=%.1f money=%d\n",
+                                   tag, p, n[p], frame[p] / n[p], cpu[p], money[p] }' "$1"
+}
+
+echo "== baseline (plain -O3)"
+configure OFF OFF ""
+cp "$ROOT/main" "$WORK/main.base"
+run_workload "$WORK/main.base" | tee "$WORK/base.txt"
+
+echo "== training"
+rm -rf "$PROFILE"
+configure GENERATE ON "$MARCH"
+run_workload "$ROOT/main" > /dev/null
+
+echo "== profile guided (LTO${MARCH:+, -march=$MARCH})"
+configure USE ON "$MARCH"
+run_workload "$ROOT/main" | tee "$WORK/pgo.txt"
+
+echo "== summary"
+summarize "$WORK/base.txt" before
+summarize "$WORK/pgo.txt" after
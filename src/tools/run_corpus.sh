@@ -0,0 +1,45 @@
+#!/bin/bash
+# 按 manifest.tsv 在语料中的每张地图上跑一局，输出每张地图的结果以及各标签的平均金钱与每帧耗时
+# 用法: tools/run_corpus.sh <语料目录> [bin目录] [-- main的参数...]
+# 环境变量 FRAMES 可缩短每局的帧数
+
+SCRIPT=$(readlink -f "$0")
+BASEDIR=$(dirname "$SCRIPT")
+ROOT=$(readlink -f "$BASEDIR/../..")
+CORPUS=${1:?usage: run_corpus.sh <corpus dir> [bin dir] [-- bot args...]}
+shift
+BIN=$ROOT
+if [ $# -gt 0 ] && [ "$1" != "--" ]; then
+    BIN=$1
+    shift
+fi
+[ "$1" == "--" ] && shift
+FRAMES=${FRAMES:-9000}
+
+tail -n +2 "$CORPUS/manifest.tsv" | while IFS=$'\t' read -r name label seed args; do
+    line=$("$BIN/headless_runner" -m "$CORPUS/$name.txt" -f "$FRAMES" -q -- "$BIN/main" -t /dev/null "$@" < /dev/null)
+    printf "%s\t%s\n" "$label" "$line"
+done | awk -F'\t' '
+    {
+        print $2
+        n = split($2, fields, " ")
+        for (i = 1; i <= n; i++) {
+            split(fields[i], kv, "=")
+            v[kv[1]] = kv[2]
+        }
+        if (!($1 in count)) {
+            order[++labels] = $1
+        }
+        count[$1]++
+        money[$1] += v["money"]
+        frame[$1] += v["avg_frame_ms"]
+        total += v["money"]
+    }
+    END {
+        printf "\n%-12s %5s %12s %12s\n", "label", "maps", "avg_money", "avg_frame_ms"
+        for (i = 1; i <= labels; i++) {
+            l = order[i]
+            printf "%-12s %5d %12.0f %12.4f\n", l, count[l], money[l] / count[l], frame[l] / count[l]
+        }
+        printf "total money %d\n", total
+    }'
@@ -0,0 +1,27 @@
+#!/bin/bash
+# 压力测试：用合成地图在不同机器人数与工作台数下各跑一局，输出耗时与得分
+# 用法: tools/stress_bench.sh [bin目录] [帧数]
+# 计时结果只对Release构建有意义（cmake -DCMAKE_BUILD_TYPE=Release）
+# 环境变量 ROBOTS、WORKTOPS 可覆盖默认的规模，如 ROBOTS="4 16 64" WORKTOPS="50 200 500"
+
+SCRIPT=$(readlink -f "$0")
+BASEDIR=$(dirname "$SCRIPT")
+ROOT=$(readlink -f "$BASEDIR/../..")
+BIN=${1:-$ROOT}
+FRAMES=${2:-9000}
+ROBOTS=${ROBOTS:-"4 16 64"}
+WORKTOPS=${WORKTOPS:-"50 200 500"}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+printf "%-7s %-9s %-10s %-12s %-12s %-10s %s\n" robots worktops startup_ms avg_frame_ms max_frame_ms cpu_ms money
+for r in $ROBOTS; do
+    for w in $WORKTOPS; do
+        map="$WORK/stress_${r}_${w}.txt"
+        "$BIN/map_generator" -s 1 -w "$w" -r "$r" -o "$map" || exit 1
+        line=$(cd "$WORK" && "$BIN/headless_runner" -m "$map" -f "$FRAMES" -q -- "$BIN/main" -t /dev/null)
+        echo "$line" | awk -v r="$r" -v w="$w" '{ for (i = 1; i <= NF; i++) { split($i, kv, "="); v[kv[1]] = kv[2] }
+            printf "%-7s %-9s %-10s %-12s %-12s %-10s %s\n", r, w, v["startup_ms"], v["avg_frame_ms"],
+                   v["max_frame_ms"], v["cpu_ms"], v["money"] }'
+    done
+done